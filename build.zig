@@ -6,7 +6,12 @@ pub fn build(b: *std.Build) !void {
     const target = b.standardTargetOptions(.{});
     const optimize = b.standardOptimizeOption(.{});
 
-    const cpp_binaries = CppBinaries.init(.{ .build = b, .target = target, .optimize = optimize });
+    const track_heap = b.option(bool, "track-heap", "Count global operator new/delete calls per measured phase in the test binaries") orelse false;
+    const cpp_flags: []const []const u8 = if (track_heap) &(CppBinaries.cflags ++ [_][]const u8{"-DTESTING_TRACK_HEAP"}) else &CppBinaries.cflags;
+    const cpp_binaries = CppBinaries.init(.{ .build = b, .target = target, .optimize = optimize, .flags = cpp_flags });
+    // The benchmark binary is always optimized and built without debug info
+    // so that its numbers do not depend on the -Doptimize of the other binaries.
+    const bench_binaries = CppBinaries.init(.{ .build = b, .target = target, .optimize = .ReleaseFast, .flags = &CppBinaries.bench_cflags });
 
     const header_file = b.addInstallFileWithDir(b.path("testing/testing.h"), .header, "testing");
     const impl_header_files = b.addInstallDirectory(.{
@@ -15,32 +20,19 @@ pub fn build(b: *std.Build) !void {
         .install_subdir = "impls",
     });
 
-    const testing_lib = testing_lib: {
-        const module = b.createModule(.{
-            .root_source_file = b.path("testing/main.zig"),
-            .optimize = optimize,
-            .target = target,
-            .link_libc = true,
-        });
-
-        module.addIncludePath(b.path("zig-out/include"));
-
-        const lib = b.addLibrary(.{
-            .name = "testing",
-            .root_module = module,
-            .linkage = .static,
-        });
-
-        lib.step.dependOn(&header_file.step);
-        b.installArtifact(lib);
-
-        break :testing_lib lib;
-    };
+    const testing_lib = create_testing_lib(b, target, optimize);
+    testing_lib.step.dependOn(&header_file.step);
+    b.installArtifact(testing_lib);
 
     const a1 = cpp_binaries.create_cpp_exe("a1", b.path("./src/a1.cc"));
+    const a2 = cpp_binaries.create_cpp_exe("a2", b.path("./src/a2.cc"));
     const b1 = cpp_binaries.create_cpp_exe("b1", b.path("./src/b1.cc"));
     const b2 = cpp_binaries.create_cpp_exe("b2", b.path("./src/b2.cc"));
     const c1 = cpp_binaries.create_cpp_exe("c1", b.path("./src/c1.cc"));
+    //a2
+    a2.linkLibrary(testing_lib);
+    a2.step.dependOn(&header_file.step);
+    a2.addIncludePath(b.path("zig-out/include"));
     //b1
     b1.linkLibrary(testing_lib);
     b1.step.dependOn(&header_file.step);
@@ -59,36 +51,85 @@ pub fn build(b: *std.Build) !void {
     c1.addIncludePath(b.path("zig-out/include"));
     const run = b.step("run", "Run all the binaries built");
     run.dependOn(&b.addRunArtifact(a1).step);
+    run.dependOn(&b.addRunArtifact(a2).step);
     run.dependOn(&b.addRunArtifact(b1).step);
     run.dependOn(&b.addRunArtifact(b2).step);
     run.dependOn(&b.addRunArtifact(c1).step);
+
+    const bench_baseline = b.option([]const u8, "bench-baseline", "Baseline file for the bench step (default bench/baseline.json)") orelse "bench/baseline.json";
+    const bench_threshold = b.option(f64, "bench-threshold", "Slowdown in percent that counts as a regression (default 10)") orelse 10;
+    const bench_update = b.option(bool, "bench-update", "Overwrite the baseline with the new results") orelse false;
+
+    //bench
+    const bench_testing_lib = create_testing_lib(b, target, .ReleaseFast);
+    bench_testing_lib.step.dependOn(&header_file.step);
+    const bench = bench_binaries.add_cpp_exe("bench", b.path("./src/bench.cc"));
+    bench.linkLibrary(bench_testing_lib);
+    bench.step.dependOn(&header_file.step);
+    bench.step.dependOn(&impl_header_files.step);
+    bench.addIncludePath(b.path("zig-out/include"));
+
+    const bench_run = b.addRunArtifact(bench);
+    bench_run.addArgs(&.{ "--baseline", b.pathFromRoot(bench_baseline) });
+    bench_run.addArgs(&.{ "--threshold", b.fmt("{d}", .{bench_threshold}) });
+    if (bench_update) bench_run.addArg("--update");
+    bench_run.has_side_effects = true;
+    const bench_step = b.step("bench", "Run the benchmarks and compare against the baseline");
+    bench_step.dependOn(&bench_run.step);
+}
+
+fn create_testing_lib(b: *std.Build, target: std.Build.ResolvedTarget, optimize: std.builtin.OptimizeMode) *Compile {
+    const module = b.createModule(.{
+        .root_source_file = b.path("testing/main.zig"),
+        .optimize = optimize,
+        .target = target,
+        .link_libc = true,
+    });
+
+    module.addIncludePath(b.path("zig-out/include"));
+
+    return b.addLibrary(.{
+        .name = "testing",
+        .root_module = module,
+        .linkage = .static,
+    });
 }
 
 const CppBinaries = struct {
     build: *std.Build,
     optimize: std.builtin.OptimizeMode,
     target: std.Build.ResolvedTarget,
+    flags: []const []const u8,
 
     pub fn init(options: struct {
         build: *std.Build,
         target: std.Build.ResolvedTarget,
         optimize: std.builtin.OptimizeMode,
+        flags: []const []const u8 = &cflags,
     }) @This() {
         return .{
             .build = options.build,
             .optimize = options.optimize,
             .target = options.target,
+            .flags = options.flags,
         };
     }
 
-    const cflags = [_][]const u8{
+    const bench_cflags = [_][]const u8{
         "-pedantic-errors",
         "-Wc++11-extensions",
         "-std=c++20",
-        "-g",
     };
+    const cflags = bench_cflags ++ [_][]const u8{"-g"};
 
     pub fn create_cpp_exe(self: @This(), name: []const u8, root_source_file: std.Build.LazyPath) *Compile {
+        const exe = self.add_cpp_exe(name, root_source_file);
+        self.build.installArtifact(exe);
+        return exe;
+    }
+
+    /// Like create_cpp_exe, but the executable is only built when a step needs it.
+    pub fn add_cpp_exe(self: @This(), name: []const u8, root_source_file: std.Build.LazyPath) *Compile {
         const module = self.build.createModule(.{
             .root_source_file = null,
             .optimize = self.optimize,
@@ -98,7 +139,7 @@ const CppBinaries = struct {
 
         module.addCSourceFile(.{
             .file = root_source_file,
-            .flags = &cflags,
+            .flags = self.flags,
             .language = .cpp,
         });
 
@@ -107,8 +148,6 @@ const CppBinaries = struct {
             .root_module = module,
         });
 
-        self.build.installArtifact(exe);
-
         return exe;
     }
 };
@@ -0,0 +1,688 @@
+#ifndef B_PLUS_TREE_HPP
+#define B_PLUS_TREE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <new>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Ordered multiset stored as a B+tree with wide, cache-aligned nodes.
+ *
+ * Every node is NodeBytes long, a multiple of the cache line, and holds as
+ * many keys as fit: a lookup touches O(log_B n) nodes instead of chasing one
+ * pointer per element as the ordered lists do. Elements live only in the
+ * leaves, which are linked left to right so iteration never climbs back up
+ * the tree. Inner nodes keep the element count of each child, which gives
+ * rank and select in O(log n) as well.
+ *
+ * Equal elements keep their insertion order: add places an element after
+ * every element equal to it.
+ *
+ * add/removeFirst/first follow the interface of OrderedList and IndexedList
+ * used by the test harness; removeFirst, first and select throw
+ * std::out_of_range when there is no such element.
+ */
+template <class T, class Compare = std::less<T>, std::size_t NodeBytes = 512>
+class BPlusTree {
+  static_assert(NodeBytes % 64 == 0, "nodes should fill whole cache lines");
+
+  struct Leaf;
+  struct Inner;
+
+public:
+  class const_iterator {
+  public:
+    const_iterator() = default;
+
+    const T &operator*() const { return leaf->key(index); }
+    const T *operator->() const { return &leaf->key(index); }
+
+    const_iterator &operator++() {
+      if (++index == leaf->count) {
+        leaf = leaf->next;
+        index = 0;
+      }
+      return *this;
+    }
+    const_iterator operator++(int) {
+      const_iterator old = *this;
+      ++*this;
+      return old;
+    }
+
+    bool operator==(const const_iterator &) const = default;
+
+  private:
+    friend class BPlusTree;
+    const_iterator(const Leaf *leaf, std::uint32_t index)
+        : leaf(leaf), index(index) {}
+
+    const Leaf *leaf = nullptr;
+    std::uint32_t index = 0;
+  };
+
+  /** @brief A pair of iterators usable in a range-based for loop. */
+  struct Range {
+    const_iterator first;
+    const_iterator last;
+    const_iterator begin() const { return first; }
+    const_iterator end() const { return last; }
+  };
+
+  BPlusTree() = default;
+  explicit BPlusTree(Compare compare) : compare(std::move(compare)) {}
+
+  ~BPlusTree() { clear(); }
+
+  BPlusTree(const BPlusTree &) = delete;
+  BPlusTree &operator=(const BPlusTree &) = delete;
+
+  void add(T element) {
+    if (!root) {
+      head = NewLeaf();
+      root = head;
+    }
+    std::optional<Split> split = insertInto(root, height, std::move(element));
+    if (split) {
+      Inner *newRoot = NewInner();
+      newRoot->count = 2;
+      newRoot->children[0] = root;
+      newRoot->children[1] = split->right;
+      newRoot->sizes[0] = SubtreeSize(root, height);
+      newRoot->sizes[1] = split->rightSize;
+      newRoot->constructKey(0, std::move(split->separator));
+      root = newRoot;
+      height++;
+    }
+    count++;
+  }
+
+  auto insert(T element) { return add(std::move(element)); }
+
+  T removeFirst() {
+    if (count == 0) {
+      throw std::out_of_range("BPlusTree is empty");
+    }
+    return removeAt(0);
+  }
+
+  const T &first() const {
+    if (count == 0) {
+      throw std::out_of_range("BPlusTree is empty");
+    }
+    return head->key(0);
+  }
+
+  /** @brief Removes and returns the element of rank index. */
+  T removeAt(std::size_t index) {
+    if (index >= count) {
+      throw std::out_of_range("BPlusTree index out of range");
+    }
+    T removed = eraseFrom(root, height, index);
+    count--;
+    shrinkRoot();
+    return removed;
+  }
+
+  /** @brief Removes the first element equal to key; false if none is. */
+  bool erase(const T &key) {
+    std::size_t index = rank(key);
+    if (index == count || compare(key, select(index))) {
+      return false;
+    }
+    removeAt(index);
+    return true;
+  }
+
+  /** @brief Number of elements ordered before key. */
+  std::size_t rank(const T &key) const {
+    if (!root) {
+      return 0;
+    }
+    std::size_t before = 0;
+    const void *node = root;
+    for (std::size_t level = height; level > 0; level--) {
+      const Inner *inner = static_cast<const Inner *>(node);
+      std::uint32_t child = inner->lowerBound(key, compare);
+      for (std::uint32_t i = 0; i < child; i++) {
+        before += inner->sizes[i];
+      }
+      node = inner->children[child];
+    }
+    return before + static_cast<const Leaf *>(node)->lowerBound(key, compare);
+  }
+
+  /** @brief The element of rank index, counting from 0. */
+  const T &select(std::size_t index) const {
+    if (index >= count) {
+      throw std::out_of_range("BPlusTree index out of range");
+    }
+    const void *node = root;
+    for (std::size_t level = height; level > 0; level--) {
+      const Inner *inner = static_cast<const Inner *>(node);
+      std::uint32_t child = 0;
+      while (index >= inner->sizes[child]) {
+        index -= inner->sizes[child++];
+      }
+      node = inner->children[child];
+    }
+    return static_cast<const Leaf *>(node)->key(index);
+  }
+
+  const_iterator begin() const {
+    return count ? const_iterator(head, 0) : end();
+  }
+  const_iterator end() const { return const_iterator(); }
+
+  /** @brief The first element not ordered before key. */
+  const_iterator lower_bound(const T &key) const {
+    return seek(key, [this](const auto &node, const T &k) {
+      return node.lowerBound(k, compare);
+    });
+  }
+
+  /** @brief The first element ordered after key. */
+  const_iterator upper_bound(const T &key) const {
+    return seek(key, [this](const auto &node, const T &k) {
+      return node.upperBound(k, compare);
+    });
+  }
+
+  /** @brief The elements in [low, high). */
+  Range range(const T &low, const T &high) const {
+    return Range{lower_bound(low), lower_bound(high)};
+  }
+
+  /**
+   * @brief Replaces the contents with items[0..n), which must already be
+   * sorted, in O(n). Nodes are filled evenly rather than split one by one,
+   * so the tree is as shallow as it can be. Throws std::invalid_argument,
+   * leaving the tree empty, if items is not sorted.
+   */
+  void bulk_load(T items[], std::size_t n) {
+    clear();
+    for (std::size_t i = 1; i < n; i++) {
+      if (compare(items[i], items[i - 1])) {
+        throw std::invalid_argument("BPlusTree::bulk_load input not sorted");
+      }
+    }
+    if (n == 0) {
+      return;
+    }
+    std::vector<void *> level;
+    std::vector<std::size_t> sizes;
+    std::size_t leaves = (n + kLeafCapacity - 1) / kLeafCapacity;
+    Leaf *previous = nullptr;
+    for (std::size_t i = 0, next = 0; i < leaves; i++) {
+      Leaf *leaf = NewLeaf();
+      std::size_t end = n * (i + 1) / leaves;
+      for (; next < end; next++) {
+        leaf->constructKey(leaf->count++, std::move(items[next]));
+      }
+      (previous ? previous->next : head) = leaf;
+      previous = leaf;
+      level.push_back(leaf);
+      sizes.push_back(leaf->count);
+    }
+    root = level[0];
+    count = n;
+    height = 0;
+    while (level.size() > 1) {
+      buildInnerLevel(level, sizes);
+      root = level[0];
+      height++;
+    }
+  }
+
+  std::size_t size() const { return count; }
+  bool isEmpty() const { return count == 0; }
+
+  void clear() {
+    if (root) {
+      Destroy(root, height);
+    }
+    root = nullptr;
+    head = nullptr;
+    count = 0;
+    height = 0;
+  }
+
+private:
+  static constexpr std::size_t kCacheLine = 64;
+  // Slots that fit beside a node's count, pointers and padding. One slot of
+  // slack lets a node overflow by one element before it splits.
+  static constexpr std::size_t kLeafSlots = (NodeBytes - 16) / sizeof(T);
+  static constexpr std::size_t kLeafCapacity =
+      kLeafSlots > 4 ? kLeafSlots - 1 : 3;
+  static constexpr std::size_t kInnerSlots =
+      (NodeBytes - 24) / (sizeof(T) + sizeof(void *) + sizeof(std::size_t));
+  static constexpr std::size_t kInnerCapacity =
+      kInnerSlots > 4 ? kInnerSlots - 1 : 3;
+  static constexpr std::size_t kLeafMinimum = kLeafCapacity / 2;
+  static constexpr std::size_t kInnerMinimum = (kInnerCapacity + 1) / 2;
+
+  // Keys live in raw storage: only slots [0, count) hold constructed
+  // elements, so an empty node constructs no T.
+  template <std::size_t Slots> struct KeyStorage {
+    alignas(T) unsigned char bytes[Slots * sizeof(T)];
+
+    T &key(std::size_t i) {
+      return *std::launder(reinterpret_cast<T *>(bytes) + i);
+    }
+    const T &key(std::size_t i) const {
+      return *std::launder(reinterpret_cast<const T *>(bytes) + i);
+    }
+    void constructKey(std::size_t i, T &&element) {
+      new (reinterpret_cast<T *>(bytes) + i) T(std::move(element));
+    }
+    // Opens a gap at i among the first n keys.
+    void shiftRight(std::size_t i, std::size_t n) {
+      if (i == n) {
+        return;
+      }
+      constructKey(n, std::move(key(n - 1)));
+      for (std::size_t j = n - 1; j > i; j--) {
+        key(j) = std::move(key(j - 1));
+      }
+      key(i).~T();
+    }
+    // Closes the gap left by a key moved out of slot i of n.
+    void shiftLeft(std::size_t i, std::size_t n) {
+      for (std::size_t j = i; j + 1 < n; j++) {
+        key(j) = std::move(key(j + 1));
+      }
+      key(n - 1).~T();
+    }
+    void destroyKeys(std::size_t n) {
+      for (std::size_t i = 0; i < n; i++) {
+        key(i).~T();
+      }
+    }
+  };
+
+  struct alignas(kCacheLine) Leaf : KeyStorage<kLeafCapacity + 1> {
+    std::uint32_t count = 0;
+    Leaf *next = nullptr;
+
+    template <class C>
+    std::uint32_t lowerBound(const T &k, const C &compare) const {
+      std::uint32_t i = 0;
+      while (i < count && compare(this->key(i), k)) {
+        i++;
+      }
+      return i;
+    }
+    template <class C>
+    std::uint32_t upperBound(const T &k, const C &compare) const {
+      std::uint32_t i = 0;
+      while (i < count && !compare(k, this->key(i))) {
+        i++;
+      }
+      return i;
+    }
+  };
+
+  // count children, separated by count - 1 keys. Every element under
+  // children[i] is ordered no later than key(i), and key(i) no later than
+  // every element under children[i + 1].
+  struct alignas(kCacheLine) Inner : KeyStorage<kInnerCapacity> {
+    std::uint32_t count = 0;
+    void *children[kInnerCapacity + 1];
+    std::size_t sizes[kInnerCapacity + 1];
+
+    template <class C>
+    std::uint32_t lowerBound(const T &k, const C &compare) const {
+      std::uint32_t i = 0;
+      while (i + 1 < count && compare(this->key(i), k)) {
+        i++;
+      }
+      return i;
+    }
+    template <class C>
+    std::uint32_t upperBound(const T &k, const C &compare) const {
+      std::uint32_t i = 0;
+      while (i + 1 < count && !compare(k, this->key(i))) {
+        i++;
+      }
+      return i;
+    }
+    void insertChild(std::uint32_t i, void *child, std::size_t size) {
+      for (std::uint32_t j = count; j > i; j--) {
+        children[j] = children[j - 1];
+        sizes[j] = sizes[j - 1];
+      }
+      children[i] = child;
+      sizes[i] = size;
+      count++;
+    }
+    void eraseChild(std::uint32_t i) {
+      for (std::uint32_t j = i; j + 1 < count; j++) {
+        children[j] = children[j + 1];
+        sizes[j] = sizes[j + 1];
+      }
+      count--;
+    }
+  };
+
+  // The right half of a node that overflowed, for its parent to adopt.
+  struct Split {
+    void *right;
+    std::size_t rightSize;
+    T separator;
+  };
+
+  static Leaf *NewLeaf() {
+    return new (::operator new(sizeof(Leaf), std::align_val_t(kCacheLine)))
+        Leaf();
+  }
+  static Inner *NewInner() {
+    return new (::operator new(sizeof(Inner), std::align_val_t(kCacheLine)))
+        Inner();
+  }
+  static void Free(Leaf *leaf) {
+    leaf->~Leaf();
+    ::operator delete(leaf, std::align_val_t(kCacheLine));
+  }
+  static void Free(Inner *inner) {
+    inner->~Inner();
+    ::operator delete(inner, std::align_val_t(kCacheLine));
+  }
+
+  static void Destroy(void *node, std::size_t level) {
+    if (level == 0) {
+      Leaf *leaf = static_cast<Leaf *>(node);
+      leaf->destroyKeys(leaf->count);
+      Free(leaf);
+      return;
+    }
+    Inner *inner = static_cast<Inner *>(node);
+    for (std::uint32_t i = 0; i < inner->count; i++) {
+      Destroy(inner->children[i], level - 1);
+    }
+    inner->destroyKeys(inner->count - 1);
+    Free(inner);
+  }
+
+  static std::size_t SubtreeSize(const void *node, std::size_t level) {
+    if (level == 0) {
+      return static_cast<const Leaf *>(node)->count;
+    }
+    const Inner *inner = static_cast<const Inner *>(node);
+    std::size_t total = 0;
+    for (std::uint32_t i = 0; i < inner->count; i++) {
+      total += inner->sizes[i];
+    }
+    return total;
+  }
+
+  static const T &SmallestKey(const void *node, std::size_t level) {
+    for (; level > 0; level--) {
+      node = static_cast<const Inner *>(node)->children[0];
+    }
+    return static_cast<const Leaf *>(node)->key(0);
+  }
+
+  template <class Bound>
+  const_iterator seek(const T &key, const Bound &bound) const {
+    if (!root) {
+      return end();
+    }
+    const void *node = root;
+    for (std::size_t level = height; level > 0; level--) {
+      const Inner *inner = static_cast<const Inner *>(node);
+      node = inner->children[bound(*inner, key)];
+    }
+    const Leaf *leaf = static_cast<const Leaf *>(node);
+    std::uint32_t index = bound(*leaf, key);
+    if (index == leaf->count) {
+      return const_iterator(leaf->next, 0);
+    }
+    return const_iterator(leaf, index);
+  }
+
+  std::optional<Split> insertInto(void *node, std::size_t level, T &&element) {
+    if (level == 0) {
+      Leaf *leaf = static_cast<Leaf *>(node);
+      std::uint32_t at = leaf->upperBound(element, compare);
+      leaf->shiftRight(at, leaf->count);
+      leaf->constructKey(at, std::move(element));
+      if (++leaf->count <= kLeafCapacity) {
+        return std::nullopt;
+      }
+      return splitLeaf(leaf);
+    }
+    Inner *inner = static_cast<Inner *>(node);
+    std::uint32_t child = inner->upperBound(element, compare);
+    std::optional<Split> split =
+        insertInto(inner->children[child], level - 1, std::move(element));
+    inner->sizes[child]++;
+    if (!split) {
+      return std::nullopt;
+    }
+    inner->sizes[child] -= split->rightSize;
+    inner->shiftRight(child, inner->count - 1);
+    inner->constructKey(child, std::move(split->separator));
+    inner->insertChild(child + 1, split->right, split->rightSize);
+    if (inner->count <= kInnerCapacity) {
+      return std::nullopt;
+    }
+    return splitInner(inner);
+  }
+
+  Split splitLeaf(Leaf *leaf) {
+    Leaf *right = NewLeaf();
+    std::uint32_t keep = leaf->count / 2;
+    for (std::uint32_t i = keep; i < leaf->count; i++) {
+      right->constructKey(right->count++, std::move(leaf->key(i)));
+      leaf->key(i).~T();
+    }
+    leaf->count = keep;
+    right->next = leaf->next;
+    leaf->next = right;
+    return Split{right, right->count, T(right->key(0))};
+  }
+
+  Split splitInner(Inner *inner) {
+    Inner *right = NewInner();
+    std::uint32_t keep = inner->count / 2;
+    std::uint32_t keys = inner->count - 1;
+    T separator = std::move(inner->key(keep - 1));
+    inner->key(keep - 1).~T();
+    for (std::uint32_t i = keep; i < keys; i++) {
+      right->constructKey(i - keep, std::move(inner->key(i)));
+      inner->key(i).~T();
+    }
+    std::size_t rightSize = 0;
+    for (std::uint32_t i = keep; i < inner->count; i++) {
+      right->children[i - keep] = inner->children[i];
+      right->sizes[i - keep] = inner->sizes[i];
+      rightSize += inner->sizes[i];
+    }
+    right->count = inner->count - keep;
+    inner->count = keep;
+    return Split{right, rightSize, std::move(separator)};
+  }
+
+  T eraseFrom(void *node, std::size_t level, std::size_t index) {
+    if (level == 0) {
+      Leaf *leaf = static_cast<Leaf *>(node);
+      T removed = std::move(leaf->key(index));
+      leaf->shiftLeft(index, leaf->count--);
+      return removed;
+    }
+    Inner *inner = static_cast<Inner *>(node);
+    std::uint32_t child = 0;
+    while (index >= inner->sizes[child]) {
+      index -= inner->sizes[child++];
+    }
+    T removed = eraseFrom(inner->children[child], level - 1, index);
+    inner->sizes[child]--;
+    std::size_t minimum = level == 1 ? kLeafMinimum : kInnerMinimum;
+    if (NodeCount(inner->children[child], level - 1) < minimum) {
+      rebalance(inner, child, level - 1);
+    }
+    return removed;
+  }
+
+  static std::uint32_t NodeCount(const void *node, std::size_t level) {
+    return level == 0 ? static_cast<const Leaf *>(node)->count
+                      : static_cast<const Inner *>(node)->count;
+  }
+
+  // Refills children[child] of parent, which fell below the minimum, from a
+  // sibling, or merges the two when they fit in one node.
+  void rebalance(Inner *parent, std::uint32_t child, std::size_t level) {
+    std::uint32_t left = child > 0 ? child - 1 : 0;
+    std::uint32_t right = left + 1;
+    void *a = parent->children[left];
+    void *b = parent->children[right];
+    std::size_t capacity = level == 0 ? kLeafCapacity : kInnerCapacity;
+    if (NodeCount(a, level) + NodeCount(b, level) <= capacity) {
+      merge(parent, left, level);
+    } else if (child == left) {
+      borrowFromRight(parent, left, level);
+    } else {
+      borrowFromLeft(parent, left, level);
+    }
+  }
+
+  void merge(Inner *parent, std::uint32_t left, std::size_t level) {
+    void *a = parent->children[left];
+    void *b = parent->children[left + 1];
+    if (level == 0) {
+      Leaf *to = static_cast<Leaf *>(a);
+      Leaf *from = static_cast<Leaf *>(b);
+      for (std::uint32_t i = 0; i < from->count; i++) {
+        to->constructKey(to->count++, std::move(from->key(i)));
+      }
+      from->destroyKeys(from->count);
+      to->next = from->next;
+      Free(from);
+    } else {
+      Inner *to = static_cast<Inner *>(a);
+      Inner *from = static_cast<Inner *>(b);
+      to->constructKey(to->count - 1, std::move(parent->key(left)));
+      for (std::uint32_t i = 0; i + 1 < from->count; i++) {
+        to->constructKey(to->count + i, std::move(from->key(i)));
+      }
+      for (std::uint32_t i = 0; i < from->count; i++) {
+        to->children[to->count + i] = from->children[i];
+        to->sizes[to->count + i] = from->sizes[i];
+      }
+      to->count += from->count;
+      from->destroyKeys(from->count - 1);
+      Free(from);
+    }
+    parent->sizes[left] += parent->sizes[left + 1];
+    parent->shiftLeft(left, parent->count - 1);
+    parent->eraseChild(left + 1);
+  }
+
+  void borrowFromRight(Inner *parent, std::uint32_t left, std::size_t level) {
+    std::size_t moved = 1;
+    if (level == 0) {
+      Leaf *to = static_cast<Leaf *>(parent->children[left]);
+      Leaf *from = static_cast<Leaf *>(parent->children[left + 1]);
+      to->constructKey(to->count++, std::move(from->key(0)));
+      from->shiftLeft(0, from->count--);
+      parent->key(left) = from->key(0);
+    } else {
+      Inner *to = static_cast<Inner *>(parent->children[left]);
+      Inner *from = static_cast<Inner *>(parent->children[left + 1]);
+      moved = from->sizes[0];
+      to->constructKey(to->count - 1, std::move(parent->key(left)));
+      to->children[to->count] = from->children[0];
+      to->sizes[to->count] = moved;
+      to->count++;
+      parent->key(left) = std::move(from->key(0));
+      from->shiftLeft(0, from->count - 1);
+      from->eraseChild(0);
+    }
+    parent->sizes[left] += moved;
+    parent->sizes[left + 1] -= moved;
+  }
+
+  void borrowFromLeft(Inner *parent, std::uint32_t left, std::size_t level) {
+    std::size_t moved = 1;
+    if (level == 0) {
+      Leaf *from = static_cast<Leaf *>(parent->children[left]);
+      Leaf *to = static_cast<Leaf *>(parent->children[left + 1]);
+      to->shiftRight(0, to->count);
+      to->constructKey(0, std::move(from->key(from->count - 1)));
+      to->count++;
+      from->key(--from->count).~T();
+      parent->key(left) = to->key(0);
+    } else {
+      Inner *from = static_cast<Inner *>(parent->children[left]);
+      Inner *to = static_cast<Inner *>(parent->children[left + 1]);
+      std::uint32_t last = from->count - 1;
+      moved = from->sizes[last];
+      to->shiftRight(0, to->count - 1);
+      to->constructKey(0, std::move(parent->key(left)));
+      to->insertChild(0, from->children[last], moved);
+      parent->key(left) = std::move(from->key(last - 1));
+      from->key(last - 1).~T();
+      from->count--;
+    }
+    parent->sizes[left] -= moved;
+    parent->sizes[left + 1] += moved;
+  }
+
+  // An inner root left with one child hands the root to it; an empty leaf
+  // root is freed.
+  void shrinkRoot() {
+    while (height > 0 && static_cast<Inner *>(root)->count == 1) {
+      Inner *old = static_cast<Inner *>(root);
+      root = old->children[0];
+      Free(old);
+      height--;
+    }
+    if (height == 0 && static_cast<Leaf *>(root)->count == 0) {
+      Free(static_cast<Leaf *>(root));
+      root = nullptr;
+      head = nullptr;
+    }
+  }
+
+  // Replaces level, the nodes of one tree level with their subtree sizes,
+  // by a level of parents spread evenly over as few nodes as possible.
+  void buildInnerLevel(std::vector<void *> &level,
+                       std::vector<std::size_t> &sizes) {
+    std::size_t nodes = (level.size() + kInnerCapacity - 1) / kInnerCapacity;
+    std::vector<void *> parents;
+    std::vector<std::size_t> parentSizes;
+    for (std::size_t i = 0, next = 0; i < nodes; i++) {
+      Inner *inner = NewInner();
+      std::size_t end = level.size() * (i + 1) / nodes;
+      std::size_t total = 0;
+      for (; next < end; next++) {
+        if (inner->count > 0) {
+          inner->constructKey(inner->count - 1,
+                              T(SmallestKey(level[next], height)));
+        }
+        inner->children[inner->count] = level[next];
+        inner->sizes[inner->count] = sizes[next];
+        inner->count++;
+        total += sizes[next];
+      }
+      parents.push_back(inner);
+      parentSizes.push_back(total);
+    }
+    level = std::move(parents);
+    sizes = std::move(parentSizes);
+  }
+
+  void *root = nullptr;
+  Leaf *head = nullptr;
+  std::size_t count = 0;
+  // Inner levels above the leaves; 0 when the root is a leaf.
+  std::size_t height = 0;
+  [[no_unique_address]] Compare compare;
+};
+
+#endif
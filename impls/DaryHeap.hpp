@@ -0,0 +1,369 @@
+#ifndef DARY_HEAP_HPP
+#define DARY_HEAP_HPP
+
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Min-heap with D children per node and optional stable handles.
+ *
+ * Keys live in a 64-byte aligned buffer shifted by D-1 slots, so the D
+ * children of any node start on a multiple of D slots. When D*sizeof(T) is
+ * 64 (D=4 for 16-byte keys, D=8 for 8-byte keys) every sibling group, which
+ * sift-down scans in full, is exactly one cache line.
+ *
+ * With StableHandles (the default) every element gets a Handle when it
+ * enters the heap. A handle stays valid until its element is extracted or
+ * erased, and is what decrease_key and erase take. Ids are reused, but each
+ * reuse bumps the id's generation, so a stale handle is never mistaken for
+ * the element that took its id over. The bookkeeping is kept out of the key
+ * buffer (ids run parallel to the keys, positions are indexed by handle) so
+ * comparisons only touch keys, but every move still updates a position:
+ * heaps that never need handles should turn them off.
+ *
+ * insert/extract/peek follow the Heap interface used by the test harness;
+ * extract and peek throw std::out_of_range when the heap is empty.
+ */
+template <class T, std::size_t D = 4, class Compare = std::less<T>,
+          bool StableHandles = true>
+class DaryHeap {
+  static_assert(D >= 2, "a heap needs at least two children per node");
+
+public:
+  struct Handle {
+    std::size_t id;
+    std::size_t generation;
+  };
+
+  DaryHeap() = default;
+  explicit DaryHeap(Compare compare) : compare(std::move(compare)) {}
+
+  ~DaryHeap() {
+    clear();
+    Release(slots);
+  }
+
+  DaryHeap(const DaryHeap &) = delete;
+  DaryHeap &operator=(const DaryHeap &) = delete;
+
+  /** @brief Returns the new element's Handle, or nothing without handles. */
+  auto insert(T element) {
+    std::size_t index = append(std::move(element));
+    if constexpr (StableHandles) {
+      Handle handle = handleAt(index);
+      siftUp(index);
+      return handle;
+    } else {
+      siftUp(index);
+    }
+  }
+
+  auto push(T element) { return insert(std::move(element)); }
+
+  /**
+   * @brief Moves n elements from items into the heap. Large batches are
+   * appended and re-heapified in O(size + n) instead of sifted one by one.
+   * @param handlesOut Optional, receives the handle of items[i] at index i.
+   */
+  void push_many(T items[], std::size_t n, Handle handlesOut[] = nullptr) {
+    reserve(count + n);
+    std::size_t first = count;
+    for (std::size_t i = 0; i < n; i++) {
+      append(std::move(items[i]));
+    }
+    if constexpr (StableHandles) {
+      for (std::size_t i = 0; handlesOut && i < n; i++) {
+        handlesOut[i] = handleAt(first + i);
+      }
+    }
+    if (n > first) {
+      heapify();
+    } else {
+      for (std::size_t i = first; i < count; i++) {
+        siftUp(i);
+      }
+    }
+  }
+
+  /** @brief Replaces the contents with items[0..n), Floyd heapify in O(n). */
+  void build(T items[], std::size_t n, Handle handlesOut[] = nullptr) {
+    clear();
+    push_many(items, n, handlesOut);
+  }
+
+  const T &peek() const {
+    if (count == 0) {
+      throw std::out_of_range("DaryHeap is empty");
+    }
+    return key(0);
+  }
+
+  T extract() {
+    if (count == 0) {
+      throw std::out_of_range("DaryHeap is empty");
+    }
+    return removeAt(0);
+  }
+
+  T pop() { return extract(); }
+
+  /** @brief Lowers the key of a live element; throws std::invalid_argument
+   * if the new key would order after the current one. */
+  void decrease_key(Handle handle, T newKey)
+    requires StableHandles
+  {
+    std::size_t index = indexOf(handle);
+    if (compare(key(index), newKey)) {
+      throw std::invalid_argument("DaryHeap::decrease_key would increase key");
+    }
+    key(index) = std::move(newKey);
+    siftUp(index);
+  }
+
+  /** @brief Removes a live element and returns it. */
+  T erase(Handle handle)
+    requires StableHandles
+  {
+    return removeAt(indexOf(handle));
+  }
+
+  bool contains(Handle handle) const
+    requires StableHandles
+  {
+    return handle.id < positions.size() &&
+           positions[handle.id] != kNoPosition &&
+           generations[handle.id] == handle.generation;
+  }
+
+  const T &get(Handle handle) const
+    requires StableHandles
+  {
+    return key(indexOf(handle));
+  }
+
+  std::size_t size() const { return count; }
+  bool isEmpty() const { return count == 0; }
+
+  void reserve(std::size_t wanted) {
+    if (wanted <= capacity) {
+      return;
+    }
+    std::size_t newCapacity = capacity ? capacity : 16;
+    while (newCapacity < wanted) {
+      newCapacity *= 2;
+    }
+    T *newSlots = Allocate(newCapacity + D - 1);
+    for (std::size_t i = 0; i < count; i++) {
+      new (&newSlots[i + D - 1]) T(std::move(key(i)));
+      key(i).~T();
+    }
+    Release(slots);
+    slots = newSlots;
+    capacity = newCapacity;
+    if constexpr (StableHandles) {
+      ids.reserve(newCapacity);
+    }
+  }
+
+  void clear() {
+    for (std::size_t i = 0; i < count; i++) {
+      key(i).~T();
+      if constexpr (StableHandles) {
+        releaseId(ids[i]);
+      }
+    }
+    count = 0;
+    ids.clear();
+  }
+
+private:
+  static constexpr std::size_t kNoPosition = static_cast<std::size_t>(-1);
+  static constexpr std::size_t kCacheLine = 64;
+
+  static T *Allocate(std::size_t n) {
+    return static_cast<T *>(
+        ::operator new(n * sizeof(T), std::align_val_t(kCacheLine)));
+  }
+  static void Release(T *p) {
+    if (p) {
+      ::operator delete(p, std::align_val_t(kCacheLine));
+    }
+  }
+
+  // Logical index i lives in slot i + D - 1, which puts the children of
+  // node i (D*i+1 .. D*i+D) at slots D*(i+1) .. D*(i+1)+D-1.
+  T &key(std::size_t i) { return slots[i + D - 1]; }
+  const T &key(std::size_t i) const { return slots[i + D - 1]; }
+
+  std::size_t idAt(std::size_t index) const {
+    if constexpr (StableHandles) {
+      return ids[index];
+    } else {
+      return 0;
+    }
+  }
+
+  Handle handleAt(std::size_t index) const {
+    return Handle{ids[index], generations[ids[index]]};
+  }
+
+  // A freed id keeps its entries in positions and generations, so handles
+  // issued before an extract, erase or clear() stay stale for good.
+  void releaseId(std::size_t id) {
+    positions[id] = kNoPosition;
+    generations[id]++;
+    freeIds.push_back(id);
+  }
+
+  std::size_t indexOf(Handle handle) const {
+    if (!contains(handle)) {
+      throw std::out_of_range("DaryHeap handle is not in the heap");
+    }
+    return positions[handle.id];
+  }
+
+  std::size_t append(T element) {
+    reserve(count + 1);
+    if constexpr (StableHandles) {
+      std::size_t id;
+      if (freeIds.empty()) {
+        id = positions.size();
+        positions.push_back(count);
+        generations.push_back(0);
+      } else {
+        id = freeIds.back();
+        freeIds.pop_back();
+        positions[id] = count;
+      }
+      ids.push_back(id);
+    }
+    new (&key(count)) T(std::move(element));
+    return count++;
+  }
+
+  T removeAt(std::size_t index) {
+    T removed = std::move(key(index));
+    if constexpr (StableHandles) {
+      releaseId(ids[index]);
+    }
+    std::size_t last = --count;
+    if (index != last) {
+      place(index, std::move(key(last)), idAt(last));
+    }
+    key(last).~T();
+    if constexpr (StableHandles) {
+      ids.pop_back();
+    }
+    if (index != last) {
+      if (index > 0 && compare(key(index), key((index - 1) / D))) {
+        siftUp(index);
+      } else {
+        siftHoleDown(index);
+      }
+    }
+    return removed;
+  }
+
+  void place(std::size_t index, T &&element, std::size_t id) {
+    key(index) = std::move(element);
+    if constexpr (StableHandles) {
+      ids[index] = id;
+      positions[id] = index;
+    }
+  }
+
+  std::size_t smallestChild(std::size_t first, std::size_t last) const {
+    std::size_t best = first;
+    for (std::size_t child = first + 1; child < last; child++) {
+      best = compare(key(child), key(best)) ? child : best;
+    }
+    return best;
+  }
+
+  void siftUp(std::size_t index) {
+    if (index == 0) {
+      return;
+    }
+    T element = std::move(key(index));
+    std::size_t id = idAt(index);
+    while (index > 0) {
+      std::size_t parent = (index - 1) / D;
+      if (!compare(element, key(parent))) {
+        break;
+      }
+      place(index, std::move(key(parent)), idAt(parent));
+      index = parent;
+    }
+    place(index, std::move(element), id);
+  }
+
+  void siftDown(std::size_t index) {
+    if (D * index + 1 >= count) {
+      return;
+    }
+    T element = std::move(key(index));
+    std::size_t id = idAt(index);
+    for (std::size_t first = D * index + 1; first < count;
+         first = D * index + 1) {
+      std::size_t best =
+          smallestChild(first, first + D < count ? first + D : count);
+      if (!compare(key(best), element)) {
+        break;
+      }
+      place(index, std::move(key(best)), idAt(best));
+      index = best;
+    }
+    place(index, std::move(element), id);
+  }
+
+  // Bottom-up sift-down for an element that came from the back of the heap:
+  // such an element almost always belongs near the leaves, so walk the hole
+  // all the way down along the smallest children without comparing against
+  // it, then sift it up the few levels it needs. This saves about one
+  // comparison (and one unpredictable branch) per level.
+  void siftHoleDown(std::size_t index) {
+    std::size_t start = index;
+    T element = std::move(key(index));
+    std::size_t id = idAt(index);
+    for (std::size_t first = D * index + 1; first < count;
+         first = D * index + 1) {
+      std::size_t best =
+          smallestChild(first, first + D < count ? first + D : count);
+      place(index, std::move(key(best)), idAt(best));
+      index = best;
+    }
+    while (index > start) {
+      std::size_t parent = (index - 1) / D;
+      if (!compare(element, key(parent))) {
+        break;
+      }
+      place(index, std::move(key(parent)), idAt(parent));
+      index = parent;
+    }
+    place(index, std::move(element), id);
+  }
+
+  void heapify() {
+    if (count < 2) {
+      return;
+    }
+    for (std::size_t i = (count - 2) / D + 1; i-- > 0;) {
+      siftDown(i);
+    }
+  }
+
+  T *slots = nullptr;
+  std::size_t count = 0;
+  std::size_t capacity = 0;
+  std::vector<std::size_t> ids;
+  std::vector<std::size_t> positions;
+  std::vector<std::size_t> freeIds;
+  std::vector<std::size_t> generations;
+  [[no_unique_address]] Compare compare;
+};
+
+#endif
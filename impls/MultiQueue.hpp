@@ -0,0 +1,280 @@
+#ifndef MULTI_QUEUE_HPP
+#define MULTI_QUEUE_HPP
+
+#include "DaryHeap.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+/**
+ * @brief Concurrent priority queue made of many sequential heaps (the
+ * MultiQueue of Rihani, Sanders and Dementiev).
+ *
+ * Elements are spread over c*P DaryHeaps, each on its own cache line behind
+ * its own try-lock. insert locks one random heap. A relaxed extract locks
+ * two random heaps and pops the smaller of their minima, so threads only
+ * meet when they pick the same heap and throughput keeps growing with the
+ * thread count. The price is order: an extract returns one of the O(c*P)
+ * smallest elements, not necessarily the smallest.
+ *
+ * In Strict mode extract locks every heap, in index order, and pops the true
+ * minimum. Extracts then serialize and cost O(c*P), but callers that need
+ * exact ordering can keep the same type.
+ *
+ * insert/extract/peek follow the Heap interface used by the test harness;
+ * extract and peek throw std::out_of_range when the queue is empty. A
+ * relaxed extract may also report empty while an insert into a heap it has
+ * already scanned is still in progress. peek and size are only exact while
+ * no other thread modifies the queue.
+ */
+template <class T, class Compare = std::less<T>> class MultiQueue {
+public:
+  enum class Ordering { Relaxed, Strict };
+
+  static constexpr std::size_t kQueuesPerThread = 2;
+
+  static std::size_t DefaultQueueCount() {
+    unsigned threads = std::thread::hardware_concurrency();
+    return kQueuesPerThread * (threads ? threads : 1);
+  }
+
+  explicit MultiQueue(std::size_t queues = DefaultQueueCount(),
+                      Ordering ordering = Ordering::Relaxed)
+      : queueCount(queues < 2 ? 2 : queues), ordering(ordering),
+        shards(new Shard[queueCount]) {}
+
+  MultiQueue(const MultiQueue &) = delete;
+  MultiQueue &operator=(const MultiQueue &) = delete;
+
+  void insert(T element) {
+    while (true) {
+      Shard &shard = shards[RandomIndex(queueCount)];
+      if (shard.try_lock()) {
+        try {
+          shard.heap.insert(std::move(element));
+        } catch (...) {
+          shard.unlock();
+          throw;
+        }
+        shard.unlock();
+        return;
+      }
+    }
+  }
+
+  auto push(T element) { return insert(std::move(element)); }
+
+  /** @brief Returns false if the queue is empty. */
+  bool try_extract(T &out) {
+    std::optional<T> element =
+        ordering == Ordering::Strict ? extractStrict() : extractRelaxed();
+    if (!element) {
+      return false;
+    }
+    out = std::move(*element);
+    return true;
+  }
+
+  T extract() {
+    std::optional<T> element =
+        ordering == Ordering::Strict ? extractStrict() : extractRelaxed();
+    if (!element) {
+      throw std::out_of_range("MultiQueue is empty");
+    }
+    return std::move(*element);
+  }
+
+  T pop() { return extract(); }
+
+  /** @brief The smallest element; not safe against concurrent extracts. */
+  const T &peek() const {
+    lockAll();
+    const Shard *best = smallestTop();
+    unlockAll();
+    if (!best) {
+      throw std::out_of_range("MultiQueue is empty");
+    }
+    return best->heap.peek();
+  }
+
+  std::size_t size() const {
+    std::size_t total = 0;
+    for (std::size_t i = 0; i < queueCount; i++) {
+      total += shards[i].size.load(std::memory_order_relaxed);
+    }
+    return total;
+  }
+
+  bool isEmpty() const { return size() == 0; }
+
+  std::size_t queues() const { return queueCount; }
+
+private:
+  static constexpr std::size_t kCacheLine = 64;
+  // Failed samples before a relaxed extract falls back to a full scan.
+  static constexpr int kSampleAttempts = 16;
+
+  struct alignas(kCacheLine) Shard {
+    std::atomic<bool> locked{false};
+    // Mirrors heap.size() so samplers can skip empty heaps without locking.
+    std::atomic<std::size_t> size{0};
+    DaryHeap<T, 4, Compare, false> heap;
+
+    bool try_lock() {
+      return !locked.load(std::memory_order_relaxed) &&
+             !locked.exchange(true, std::memory_order_acquire);
+    }
+    void lock() {
+      while (!try_lock()) {
+        std::this_thread::yield();
+      }
+    }
+    void unlock() {
+      size.store(heap.size(), std::memory_order_relaxed);
+      locked.store(false, std::memory_order_release);
+    }
+    bool looksEmpty() const {
+      return size.load(std::memory_order_relaxed) == 0;
+    }
+  };
+
+  // Lock holders may have been preempted when threads outnumber cores.
+  static void Backoff(unsigned failures) {
+    if (failures % 16 == 0) {
+      std::this_thread::yield();
+    }
+  }
+
+  // splitmix64 of a per-thread counter, so no two threads share a stream.
+  static std::uint64_t ThreadSeed() {
+    static std::atomic<std::uint64_t> threads{0};
+    std::uint64_t z = (threads.fetch_add(1, std::memory_order_relaxed) + 1) *
+                      0x9e3779b97f4a7c15ULL;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return (z ^ (z >> 31)) | 1;
+  }
+
+  // xorshift64* per thread; an index below n by multiply-shift.
+  static std::size_t RandomIndex(std::size_t n) {
+    thread_local std::uint64_t state = ThreadSeed();
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    std::uint64_t random = (state * 0x2545f4914f6cdd1dULL) >> 32;
+    return static_cast<std::size_t>((random * n) >> 32);
+  }
+
+  const Shard *better(const Shard *a, const Shard *b) const {
+    if (a->heap.isEmpty()) {
+      return b->heap.isEmpty() ? nullptr : b;
+    }
+    if (b->heap.isEmpty()) {
+      return a;
+    }
+    return compare(b->heap.peek(), a->heap.peek()) ? b : a;
+  }
+
+  std::optional<T> extractRelaxed() {
+    // Only samples that found both heaps empty count towards the fallback;
+    // a lost try-lock just means another thread is working there.
+    int emptySamples = 0;
+    for (unsigned contended = 0; emptySamples < kSampleAttempts;) {
+      Shard &first = shards[RandomIndex(queueCount)];
+      Shard &second = shards[RandomIndex(queueCount)];
+      if (&first == &second) {
+        continue;
+      }
+      if (first.looksEmpty() && second.looksEmpty()) {
+        emptySamples++;
+        continue;
+      }
+      if (!first.try_lock()) {
+        Backoff(++contended);
+        continue;
+      }
+      if (!second.try_lock()) {
+        first.unlock();
+        Backoff(++contended);
+        continue;
+      }
+      Shard *best = const_cast<Shard *>(better(&first, &second));
+      std::optional<T> element;
+      if (best) {
+        element.emplace(best->heap.extract());
+      }
+      second.unlock();
+      first.unlock();
+      if (element) {
+        return element;
+      }
+      emptySamples++;
+    }
+    // Mostly empty: take from any heap that still has something.
+    std::size_t start = RandomIndex(queueCount);
+    for (std::size_t i = 0; i < queueCount; i++) {
+      Shard &shard = shards[(start + i) % queueCount];
+      if (shard.looksEmpty()) {
+        continue;
+      }
+      shard.lock();
+      std::optional<T> element;
+      if (!shard.heap.isEmpty()) {
+        element.emplace(shard.heap.extract());
+      }
+      shard.unlock();
+      if (element) {
+        return element;
+      }
+    }
+    return std::nullopt;
+  }
+
+  std::optional<T> extractStrict() {
+    lockAll();
+    Shard *best = const_cast<Shard *>(smallestTop());
+    std::optional<T> element;
+    if (best) {
+      element.emplace(best->heap.extract());
+    }
+    unlockAll();
+    return element;
+  }
+
+  // Locks are always taken in index order, so two full scans cannot
+  // deadlock, and the single-heap paths only ever try-lock.
+  void lockAll() const {
+    for (std::size_t i = 0; i < queueCount; i++) {
+      shards[i].lock();
+    }
+  }
+  void unlockAll() const {
+    for (std::size_t i = queueCount; i-- > 0;) {
+      shards[i].unlock();
+    }
+  }
+
+  const Shard *smallestTop() const {
+    const Shard *best = nullptr;
+    for (std::size_t i = 0; i < queueCount; i++) {
+      const Shard *shard = &shards[i];
+      if (!shard->heap.isEmpty()) {
+        best = best ? better(best, shard) : shard;
+      }
+    }
+    return best;
+  }
+
+  std::size_t queueCount;
+  Ordering ordering;
+  [[no_unique_address]] Compare compare;
+  std::unique_ptr<Shard[]> shards;
+};
+
+#endif
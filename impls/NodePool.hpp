@@ -0,0 +1,510 @@
+#ifndef NODE_POOL_HPP
+#define NODE_POOL_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+/**
+ * @brief Counters kept by a NodePool. `allocations`/`deallocations` count
+ * node requests from the container; `heap_allocations` counts the calls that
+ * actually reached the global heap (one per chunk, or per oversized request).
+ */
+struct NodePoolStats {
+  unsigned long long allocations = 0;
+  unsigned long long deallocations = 0;
+  unsigned long long heap_allocations = 0;
+};
+
+/**
+ * @brief Fixed-size slab allocator with an intrusive free list.
+ *
+ * Nodes are carved out of large cache-line-aligned chunks. Freed nodes go on
+ * a free list and are handed out again before any new chunk is requested;
+ * memory only returns to the heap when the pool is destroyed. Chunk sizes
+ * double from kFirstChunkNodes up to kMaxChunkNodes.
+ */
+class NodePool {
+public:
+  static constexpr std::size_t kCacheLine = 64;
+  static constexpr std::size_t kFirstChunkNodes = 64;
+  static constexpr std::size_t kMaxChunkNodes = 1 << 16;
+
+  // Alignments above kCacheLine are not supported.
+  NodePool(std::size_t nodeSize, std::size_t nodeAlign)
+      : stride(StrideFor(nodeSize, nodeAlign)) {}
+
+  ~NodePool() {
+    while (chunks) {
+      Chunk *next = chunks->next;
+      ::operator delete(chunks, std::align_val_t(kCacheLine));
+      chunks = next;
+    }
+  }
+
+  NodePool(const NodePool &) = delete;
+  NodePool &operator=(const NodePool &) = delete;
+
+  void *allocate() {
+    counters.allocations++;
+    if (freeList) {
+      FreeNode *node = freeList;
+      freeList = node->next;
+      return node;
+    }
+    if (bump == bumpEnd) {
+      grow();
+    }
+    void *node = bump;
+    bump += stride;
+    return node;
+  }
+
+  void deallocate(void *node) {
+    counters.deallocations++;
+    FreeNode *freed = static_cast<FreeNode *>(node);
+    freed->next = freeList;
+    freeList = freed;
+  }
+
+  /** @brief Distance between nodes; pools with equal strides are
+   * interchangeable. */
+  static constexpr std::size_t StrideFor(std::size_t nodeSize,
+                                         std::size_t nodeAlign) {
+    return RoundUp(nodeSize < sizeof(FreeNode) ? sizeof(FreeNode) : nodeSize,
+                   nodeAlign < alignof(FreeNode) ? alignof(FreeNode)
+                                                 : nodeAlign);
+  }
+
+  std::size_t nodeSize() const { return stride; }
+  const NodePoolStats &stats() const { return counters; }
+
+  // Requests that are not a single node bypass the pool but are still
+  // counted, so a container's statistics stay complete.
+  void *allocateOversized(std::size_t bytes, std::size_t align) {
+    counters.allocations++;
+    counters.heap_allocations++;
+    return ::operator new(bytes, std::align_val_t(align));
+  }
+
+  void deallocateOversized(void *p, std::size_t align) {
+    counters.deallocations++;
+    ::operator delete(p, std::align_val_t(align));
+  }
+
+private:
+  struct FreeNode {
+    FreeNode *next;
+  };
+  struct alignas(kCacheLine) Chunk {
+    Chunk *next;
+  };
+
+  static constexpr std::size_t RoundUp(std::size_t n, std::size_t align) {
+    return (n + align - 1) / align * align;
+  }
+
+  void grow() {
+    std::size_t header = RoundUp(sizeof(Chunk), kCacheLine);
+    Chunk *chunk = static_cast<Chunk *>(::operator new(
+        header + chunkNodes * stride, std::align_val_t(kCacheLine)));
+    counters.heap_allocations++;
+    chunk->next = chunks;
+    chunks = chunk;
+    bump = reinterpret_cast<unsigned char *>(chunk) + header;
+    bumpEnd = bump + chunkNodes * stride;
+    if (chunkNodes < kMaxChunkNodes) {
+      chunkNodes *= 2;
+    }
+  }
+
+  std::size_t stride;
+  std::size_t chunkNodes = kFirstChunkNodes;
+  FreeNode *freeList = nullptr;
+  unsigned char *bump = nullptr;
+  unsigned char *bumpEnd = nullptr;
+  Chunk *chunks = nullptr;
+  NodePoolStats counters;
+};
+
+/**
+ * @brief A set of NodePools, one per node size, shared by an allocator and
+ * everything rebound from it. Statistics are summed over all pools.
+ */
+class NodePoolResource {
+public:
+  NodePool &poolFor(std::size_t nodeSize, std::size_t nodeAlign) {
+    std::size_t stride = NodePool::StrideFor(nodeSize, nodeAlign);
+    for (const std::unique_ptr<NodePool> &pool : pools) {
+      if (pool->nodeSize() == stride) {
+        return *pool;
+      }
+    }
+    pools.push_back(std::make_unique<NodePool>(nodeSize, nodeAlign));
+    return *pools.back();
+  }
+
+  NodePoolStats stats() const {
+    NodePoolStats total;
+    for (const std::unique_ptr<NodePool> &pool : pools) {
+      total.allocations += pool->stats().allocations;
+      total.deallocations += pool->stats().deallocations;
+      total.heap_allocations += pool->stats().heap_allocations;
+    }
+    return total;
+  }
+
+private:
+  std::vector<std::unique_ptr<NodePool>> pools;
+};
+
+/**
+ * @brief Standard allocator backed by a NodePool, meant as the Allocator
+ * parameter of node-based containers:
+ *
+ *   template <class T, class Allocator = PoolAllocator<T>>
+ *   class StackLinkedList { ...
+ *     using NodeAllocator = typename std::allocator_traits<
+ *         Allocator>::template rebind_alloc<Node>;
+ *
+ * Copies and rebinds share one NodePoolResource, so a container's node
+ * allocator and the allocator it hands back report the same statistics.
+ * Single-object requests come from the pool; arrays go straight to the heap.
+ */
+template <class T> class PoolAllocator {
+public:
+  using value_type = T;
+  using propagate_on_container_copy_assignment = std::true_type;
+  using propagate_on_container_move_assignment = std::true_type;
+  using propagate_on_container_swap = std::true_type;
+
+  PoolAllocator()
+      : resource(std::make_shared<NodePoolResource>()),
+        pool(&resource->poolFor(sizeof(T), alignof(T))) {}
+  template <class U>
+  PoolAllocator(const PoolAllocator<U> &other)
+      : resource(other.resource),
+        pool(&resource->poolFor(sizeof(T), alignof(T))) {}
+
+  T *allocate(std::size_t n) {
+    if (n == 1) {
+      return static_cast<T *>(pool->allocate());
+    }
+    return static_cast<T *>(pool->allocateOversized(n * sizeof(T), Align()));
+  }
+
+  void deallocate(T *p, std::size_t n) {
+    if (n == 1) {
+      pool->deallocate(p);
+    } else {
+      pool->deallocateOversized(p, Align());
+    }
+  }
+
+  NodePoolStats stats() const { return resource->stats(); }
+
+  template <class U> bool operator==(const PoolAllocator<U> &other) const {
+    return resource == other.resource;
+  }
+
+private:
+  template <class U> friend class PoolAllocator;
+
+  static constexpr std::size_t Align() {
+    return alignof(T) < alignof(std::max_align_t) ? alignof(std::max_align_t)
+                                                  : alignof(T);
+  }
+
+  std::shared_ptr<NodePoolResource> resource;
+  NodePool *pool;
+};
+
+/**
+ * @brief std::allocator that counts its calls, every one of which reaches the
+ * global heap. The unpooled baseline for PoolAllocator: copies and rebinds
+ * share one set of counters.
+ */
+template <class T> class CountingAllocator {
+public:
+  using value_type = T;
+
+  CountingAllocator() : counters(std::make_shared<NodePoolStats>()) {}
+  template <class U>
+  CountingAllocator(const CountingAllocator<U> &other)
+      : counters(other.counters) {}
+
+  T *allocate(std::size_t n) {
+    counters->allocations++;
+    counters->heap_allocations++;
+    return std::allocator<T>().allocate(n);
+  }
+
+  void deallocate(T *p, std::size_t n) {
+    counters->deallocations++;
+    std::allocator<T>().deallocate(p, n);
+  }
+
+  NodePoolStats stats() const { return *counters; }
+
+  template <class U>
+  bool operator==(const CountingAllocator<U> &other) const {
+    return counters == other.counters;
+  }
+
+private:
+  template <class U> friend class CountingAllocator;
+
+  std::shared_ptr<NodePoolStats> counters;
+};
+
+/**
+ * @brief The per-thread pools behind ThreadLocalPoolAllocator.
+ *
+ * Unlike NodePool, nodes may be returned on any thread. Chunks are kChunkBytes
+ * large and aligned to their size, and start with a header naming the pool
+ * that owns them, so the owner of a node is found by masking its address.
+ * Frees on the owning thread go on a plain free list; frees on other threads
+ * are pushed onto the owner's atomic remote list, which the owner takes over
+ * once its own list runs dry. When the owning thread exits the pool is
+ * orphaned and deletes itself, chunks and all, when its last node comes back.
+ */
+class ThreadNodePool {
+public:
+  static constexpr std::size_t kCacheLine = NodePool::kCacheLine;
+  static constexpr std::size_t kChunkBytes = std::size_t(64) << 10;
+
+  /** @brief Whether nodes of this stride come from a pool at all; larger
+   * ones go straight to the heap. */
+  static constexpr bool Pooled(std::size_t stride) {
+    return stride <= (kChunkBytes - kHeaderBytes) / 16;
+  }
+
+  /** @brief The calling thread's pool for nodes of stride bytes. */
+  static ThreadNodePool &ForStride(std::size_t stride) {
+    return Registry::Current().poolFor(stride);
+  }
+
+  /** @brief Statistics summed over every pool of the calling thread. */
+  static NodePoolStats ThreadStats() { return Registry::Current().stats(); }
+
+  void *allocate() {
+    counters.allocations++;
+    handedOut++;
+    if (!freeList) {
+      freeList = remoteFree.exchange(nullptr, std::memory_order_acquire);
+    }
+    if (freeList) {
+      FreeNode *node = freeList;
+      freeList = node->next;
+      return node;
+    }
+    if (bump == bumpEnd) {
+      grow();
+    }
+    void *node = bump;
+    bump += stride;
+    return node;
+  }
+
+  /** @brief Returns a node of this pool's stride, allocated on any thread.
+   * Must be called on the thread that owns this pool. */
+  void deallocate(void *node) {
+    counters.deallocations++;
+    ThreadNodePool *owner = OwnerOf(node);
+    FreeNode *freed = static_cast<FreeNode *>(node);
+    if (owner == this) {
+      freed->next = freeList;
+      freeList = freed;
+      handedOut--;
+      return;
+    }
+    FreeNode *head = owner->remoteFree.load(std::memory_order_relaxed);
+    do {
+      freed->next = head;
+    } while (!owner->remoteFree.compare_exchange_weak(
+        head, freed, std::memory_order_release, std::memory_order_relaxed));
+    owner->ReleaseRemote();
+  }
+
+  std::size_t nodeSize() const { return stride; }
+  const NodePoolStats &stats() const { return counters; }
+
+  void *allocateOversized(std::size_t bytes, std::size_t align) {
+    counters.allocations++;
+    counters.heap_allocations++;
+    return ::operator new(bytes, std::align_val_t(align));
+  }
+
+  void deallocateOversized(void *p, std::size_t align) {
+    counters.deallocations++;
+    ::operator delete(p, std::align_val_t(align));
+  }
+
+private:
+  struct FreeNode {
+    FreeNode *next;
+  };
+  struct alignas(kCacheLine) Chunk {
+    ThreadNodePool *owner;
+    Chunk *next;
+  };
+  static constexpr std::size_t kHeaderBytes =
+      (sizeof(Chunk) + kCacheLine - 1) / kCacheLine * kCacheLine;
+
+  // One pool per stride for each thread; orphans them at thread exit.
+  class Registry {
+  public:
+    static Registry &Current() {
+      thread_local Registry registry;
+      return registry;
+    }
+
+    ~Registry() {
+      for (ThreadNodePool *pool : pools) {
+        pool->Orphan();
+      }
+    }
+
+    ThreadNodePool &poolFor(std::size_t stride) {
+      for (ThreadNodePool *pool : pools) {
+        if (pool->stride == stride) {
+          return *pool;
+        }
+      }
+      pools.push_back(new ThreadNodePool(stride));
+      return *pools.back();
+    }
+
+    NodePoolStats stats() const {
+      NodePoolStats total;
+      for (const ThreadNodePool *pool : pools) {
+        total.allocations += pool->counters.allocations;
+        total.deallocations += pool->counters.deallocations;
+        total.heap_allocations += pool->counters.heap_allocations;
+      }
+      return total;
+    }
+
+  private:
+    std::vector<ThreadNodePool *> pools;
+  };
+
+  explicit ThreadNodePool(std::size_t stride) : stride(stride) {}
+
+  ~ThreadNodePool() {
+    while (chunks) {
+      Chunk *next = chunks->next;
+      ::operator delete(chunks, std::align_val_t(kChunkBytes));
+      chunks = next;
+    }
+  }
+
+  static ThreadNodePool *OwnerOf(void *node) {
+    auto address = reinterpret_cast<std::uintptr_t>(node);
+    return reinterpret_cast<Chunk *>(address & ~(kChunkBytes - 1))->owner;
+  }
+
+  // remoteBalance is minus the nodes returned by other threads until the
+  // owner exits and adds the nodes it still has out, so it only reaches zero
+  // once the pool is orphaned and every node is back.
+  void ReleaseRemote() {
+    if (remoteBalance.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      delete this;
+    }
+  }
+
+  void Orphan() {
+    // Read before publishing: once the balance can reach zero, another
+    // thread may delete the pool.
+    long long outstanding = handedOut;
+    if (remoteBalance.fetch_add(outstanding, std::memory_order_acq_rel) +
+            outstanding ==
+        0) {
+      delete this;
+    }
+  }
+
+  void grow() {
+    Chunk *chunk = static_cast<Chunk *>(
+        ::operator new(kChunkBytes, std::align_val_t(kChunkBytes)));
+    counters.heap_allocations++;
+    chunk->owner = this;
+    chunk->next = chunks;
+    chunks = chunk;
+    bump = reinterpret_cast<unsigned char *>(chunk) + kHeaderBytes;
+    bumpEnd = bump + (kChunkBytes - kHeaderBytes) / stride * stride;
+  }
+
+  std::size_t stride;
+  FreeNode *freeList = nullptr;
+  unsigned char *bump = nullptr;
+  unsigned char *bumpEnd = nullptr;
+  Chunk *chunks = nullptr;
+  // Nodes handed out minus those returned on this thread; owner only.
+  long long handedOut = 0;
+  NodePoolStats counters;
+  alignas(kCacheLine) std::atomic<FreeNode *> remoteFree{nullptr};
+  std::atomic<long long> remoteBalance{0};
+};
+
+/**
+ * @brief Stateless allocator drawing from pools private to the calling
+ * thread, so allocating and freeing on one thread never synchronizes. All
+ * instances are equal, and nodes may be freed on any thread: they go back to
+ * the pool that allocated them, which outlives its thread until the last of
+ * its nodes is returned.
+ */
+template <class T> class ThreadLocalPoolAllocator {
+public:
+  using value_type = T;
+  using is_always_equal = std::true_type;
+
+  ThreadLocalPoolAllocator() = default;
+  template <class U>
+  ThreadLocalPoolAllocator(const ThreadLocalPoolAllocator<U> &) {}
+
+  T *allocate(std::size_t n) {
+    if (n == 1 && ThreadNodePool::Pooled(kStride)) {
+      return static_cast<T *>(Pool().allocate());
+    }
+    return static_cast<T *>(Pool().allocateOversized(n * sizeof(T), Align()));
+  }
+
+  void deallocate(T *p, std::size_t n) {
+    if (n == 1 && ThreadNodePool::Pooled(kStride)) {
+      Pool().deallocate(p);
+    } else {
+      Pool().deallocateOversized(p, Align());
+    }
+  }
+
+  /** @brief Statistics of the calling thread, summed over its pools for
+   * every node size, so they include whatever a container rebinds to. */
+  NodePoolStats stats() const { return ThreadNodePool::ThreadStats(); }
+
+  template <class U>
+  bool operator==(const ThreadLocalPoolAllocator<U> &) const {
+    return true;
+  }
+
+private:
+  static constexpr std::size_t kStride = NodePool::StrideFor(sizeof(T),
+                                                             alignof(T));
+
+  static constexpr std::size_t Align() {
+    return alignof(T) < alignof(std::max_align_t) ? alignof(std::max_align_t)
+                                                  : alignof(T);
+  }
+
+  static ThreadNodePool &Pool() {
+    // Cached per thread and T; the registry owns the pool.
+    thread_local ThreadNodePool *pool = &ThreadNodePool::ForStride(kStride);
+    return *pool;
+  }
+};
+
+#endif
@@ -0,0 +1,113 @@
+#ifndef QUEUE_NODE_LIST_HPP
+#define QUEUE_NODE_LIST_HPP
+
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+/**
+ * @brief Singly linked FIFO queue whose nodes come from Allocator.
+ *
+ * Every enqueue allocates one node and every dequeue frees one, so the queue
+ * shows directly what the allocator costs: with std::allocator each operation
+ * is a heap call, with PoolAllocator or ThreadLocalPoolAllocator nodes are
+ * recycled. If the allocator reports stats(), they are exposed as
+ * allocator_stats() for the testing harness.
+ */
+template <class T, class Allocator = std::allocator<T>> class QueueNodeList {
+public:
+  QueueNodeList() = default;
+  explicit QueueNodeList(const Allocator &allocator) : nodes(allocator) {}
+
+  ~QueueNodeList() {
+    while (head) {
+      Node *next = head->next;
+      Destroy(head);
+      head = next;
+    }
+  }
+
+  QueueNodeList(const QueueNodeList &) = delete;
+  QueueNodeList &operator=(const QueueNodeList &) = delete;
+
+  void enqueue(const T &element) { Append(element); }
+  void enqueue(T &&element) { Append(std::move(element)); }
+
+  /** @brief Throws std::out_of_range if empty. */
+  T dequeue() {
+    if (!head) {
+      throw std::out_of_range("QueueNodeList is empty");
+    }
+    Node *node = head;
+    head = node->next;
+    if (!head) {
+      tail = nullptr;
+    }
+    count--;
+    T element = std::move(node->value);
+    Destroy(node);
+    return element;
+  }
+
+  /** @brief Throws std::out_of_range if empty. */
+  const T &peek() const {
+    if (!head) {
+      throw std::out_of_range("QueueNodeList is empty");
+    }
+    return head->value;
+  }
+
+  bool isEmpty() const { return count == 0; }
+  std::size_t size() const { return count; }
+
+  Allocator get_allocator() const { return Allocator(nodes); }
+
+  auto allocator_stats() const
+    requires requires(const Allocator &allocator) { allocator.stats(); }
+  {
+    return nodes.stats();
+  }
+
+private:
+  struct Node {
+    template <class U>
+    explicit Node(U &&value) : value(std::forward<U>(value)) {}
+
+    T value;
+    Node *next = nullptr;
+  };
+
+  using NodeAllocator = typename std::allocator_traits<
+      Allocator>::template rebind_alloc<Node>;
+  using NodeTraits = std::allocator_traits<NodeAllocator>;
+
+  template <class U> void Append(U &&element) {
+    Node *node = NodeTraits::allocate(nodes, 1);
+    try {
+      NodeTraits::construct(nodes, node, std::forward<U>(element));
+    } catch (...) {
+      NodeTraits::deallocate(nodes, node, 1);
+      throw;
+    }
+    if (tail) {
+      tail->next = node;
+    } else {
+      head = node;
+    }
+    tail = node;
+    count++;
+  }
+
+  void Destroy(Node *node) {
+    NodeTraits::destroy(nodes, node);
+    NodeTraits::deallocate(nodes, node, 1);
+  }
+
+  NodeAllocator nodes;
+  Node *head = nullptr;
+  Node *tail = nullptr;
+  std::size_t count = 0;
+};
+
+#endif
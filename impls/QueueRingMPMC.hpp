@@ -0,0 +1,175 @@
+#ifndef QUEUE_RING_MPMC_HPP
+#define QUEUE_RING_MPMC_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <stdexcept>
+#include <utility>
+
+/**
+ * @brief Bounded lock-free multi-producer/multi-consumer ring buffer
+ * (Dmitry Vyukov's design).
+ *
+ * Every cell carries a sequence number telling whose turn it is: equal to
+ * the enqueue position when the cell is free for that producer, and one past
+ * it once the element is published for the consumer at that position.
+ * Producers and consumers claim positions with a single CAS on their own
+ * cache-line-padded counter, so the two sides never contend with each other.
+ *
+ * enqueue/dequeue follow the QueueArray interface and throw
+ * std::overflow_error when full and std::out_of_range when empty.
+ * peek is only meaningful while no other thread dequeues.
+ */
+template <class T> class QueueRingMPMC {
+public:
+  static constexpr std::size_t kDefaultCapacity = 1 << 16;
+
+  explicit QueueRingMPMC(std::size_t capacity = kDefaultCapacity) {
+    std::size_t rounded = 2;
+    while (rounded < capacity) {
+      rounded <<= 1;
+    }
+    mask = rounded - 1;
+    cells = new Cell[rounded];
+    for (std::size_t i = 0; i < rounded; i++) {
+      cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  // Destroys what is left in place, so T needs no default constructor.
+  // Only published cells hold an element.
+  ~QueueRingMPMC() {
+    std::size_t position = dequeuePosition.load(std::memory_order_relaxed);
+    std::size_t end = enqueuePosition.load(std::memory_order_relaxed);
+    for (; position != end; position++) {
+      Cell &cell = cells[position & mask];
+      if (cell.sequence.load(std::memory_order_acquire) == position + 1) {
+        cell.element()->~T();
+      }
+    }
+    delete[] cells;
+  }
+
+  QueueRingMPMC(const QueueRingMPMC &) = delete;
+  QueueRingMPMC &operator=(const QueueRingMPMC &) = delete;
+
+  /** @brief Returns false if the queue is full. */
+  template <class U> bool try_enqueue(U &&element) {
+    std::size_t position = enqueuePosition.load(std::memory_order_relaxed);
+    Cell *cell;
+    while (true) {
+      cell = &cells[position & mask];
+      std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+      std::ptrdiff_t difference = static_cast<std::ptrdiff_t>(sequence) -
+                                  static_cast<std::ptrdiff_t>(position);
+      if (difference == 0) {
+        if (enqueuePosition.compare_exchange_weak(
+                position, position + 1, std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (difference < 0) {
+        return false;
+      } else {
+        position = enqueuePosition.load(std::memory_order_relaxed);
+      }
+    }
+    new (cell->storage) T(std::forward<U>(element));
+    cell->sequence.store(position + 1, std::memory_order_release);
+    return true;
+  }
+
+  /** @brief Returns false if the queue is empty. */
+  bool try_dequeue(T &out) {
+    Cell *cell = claimForDequeue();
+    if (!cell) {
+      return false;
+    }
+    out = std::move(*cell->element());
+    release(cell);
+    return true;
+  }
+
+  void enqueue(const T &element) {
+    if (!try_enqueue(element)) {
+      throw std::overflow_error("QueueRingMPMC is full");
+    }
+  }
+
+  void enqueue(T &&element) {
+    if (!try_enqueue(std::move(element))) {
+      throw std::overflow_error("QueueRingMPMC is full");
+    }
+  }
+
+  T dequeue() {
+    Cell *cell = claimForDequeue();
+    if (!cell) {
+      throw std::out_of_range("QueueRingMPMC is empty");
+    }
+    T element = std::move(*cell->element());
+    release(cell);
+    return element;
+  }
+
+  /** @brief Front element; not safe against concurrent dequeues. */
+  const T &peek() const {
+    std::size_t position = dequeuePosition.load(std::memory_order_relaxed);
+    const Cell &cell = cells[position & mask];
+    if (cell.sequence.load(std::memory_order_acquire) != position + 1) {
+      throw std::out_of_range("QueueRingMPMC is empty");
+    }
+    return *std::launder(reinterpret_cast<const T *>(cell.storage));
+  }
+
+  bool isEmpty() const {
+    return enqueuePosition.load(std::memory_order_acquire) ==
+           dequeuePosition.load(std::memory_order_acquire);
+  }
+
+  std::size_t capacity() const { return mask + 1; }
+
+private:
+  static constexpr std::size_t kCacheLine = 64;
+
+  struct Cell {
+    std::atomic<std::size_t> sequence;
+    alignas(T) unsigned char storage[sizeof(T)];
+    T *element() { return std::launder(reinterpret_cast<T *>(storage)); }
+  };
+
+  Cell *claimForDequeue() {
+    std::size_t position = dequeuePosition.load(std::memory_order_relaxed);
+    while (true) {
+      Cell *cell = &cells[position & mask];
+      std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+      std::ptrdiff_t difference = static_cast<std::ptrdiff_t>(sequence) -
+                                  static_cast<std::ptrdiff_t>(position + 1);
+      if (difference == 0) {
+        if (dequeuePosition.compare_exchange_weak(
+                position, position + 1, std::memory_order_relaxed)) {
+          return cell;
+        }
+      } else if (difference < 0) {
+        return nullptr;
+      } else {
+        position = dequeuePosition.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  // Destroys the dequeued element and hands the cell to the producer one lap
+  // ahead.
+  void release(Cell *cell) {
+    std::size_t position = cell->sequence.load(std::memory_order_relaxed) - 1;
+    cell->element()->~T();
+    cell->sequence.store(position + mask + 1, std::memory_order_release);
+  }
+
+  alignas(kCacheLine) std::atomic<std::size_t> enqueuePosition{0};
+  alignas(kCacheLine) std::atomic<std::size_t> dequeuePosition{0};
+  alignas(kCacheLine) Cell *cells;
+  std::size_t mask;
+};
+
+#endif
@@ -0,0 +1,141 @@
+#ifndef QUEUE_RING_SPSC_HPP
+#define QUEUE_RING_SPSC_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <stdexcept>
+#include <utility>
+
+/**
+ * @brief Bounded lock-free single-producer/single-consumer ring buffer.
+ *
+ * One thread may enqueue while one other thread dequeues, with no locks.
+ * The producer's and the consumer's indices live on separate cache lines.
+ * Each side also keeps a cached copy of the other side's index, so it only
+ * touches the shared line when the cached value says the queue looks full
+ * (or empty).
+ *
+ * enqueue/dequeue/peek follow the QueueArray interface so the queue can be
+ * driven by the testing harness: they throw std::overflow_error when full
+ * and std::out_of_range when empty. try_enqueue/try_dequeue report the same
+ * conditions without exceptions.
+ */
+template <class T> class QueueRingSPSC {
+public:
+  static constexpr std::size_t kDefaultCapacity = 1 << 16;
+
+  explicit QueueRingSPSC(std::size_t capacity = kDefaultCapacity) {
+    std::size_t rounded = 2;
+    while (rounded < capacity) {
+      rounded <<= 1;
+    }
+    mask = rounded - 1;
+    slots = static_cast<T *>(::operator new(rounded * sizeof(T),
+                                            std::align_val_t(kCacheLine)));
+  }
+
+  ~QueueRingSPSC() {
+    std::size_t head = consumer.head.load(std::memory_order_relaxed);
+    std::size_t tail = producer.tail.load(std::memory_order_relaxed);
+    for (; head != tail; head++) {
+      slots[head & mask].~T();
+    }
+    ::operator delete(slots, std::align_val_t(kCacheLine));
+  }
+
+  QueueRingSPSC(const QueueRingSPSC &) = delete;
+  QueueRingSPSC &operator=(const QueueRingSPSC &) = delete;
+
+  /** @brief Producer side. Returns false if the queue is full. */
+  template <class U> bool try_enqueue(U &&element) {
+    std::size_t tail = producer.tail.load(std::memory_order_relaxed);
+    if (tail - producer.cachedHead > mask) {
+      producer.cachedHead = consumer.head.load(std::memory_order_acquire);
+      if (tail - producer.cachedHead > mask) {
+        return false;
+      }
+    }
+    new (&slots[tail & mask]) T(std::forward<U>(element));
+    producer.tail.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  /** @brief Consumer side. Returns false if the queue is empty. */
+  bool try_dequeue(T &out) {
+    std::size_t head = consumer.head.load(std::memory_order_relaxed);
+    if (head == consumer.cachedTail) {
+      consumer.cachedTail = producer.tail.load(std::memory_order_acquire);
+      if (head == consumer.cachedTail) {
+        return false;
+      }
+    }
+    T &slot = slots[head & mask];
+    out = std::move(slot);
+    slot.~T();
+    consumer.head.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  void enqueue(const T &element) {
+    if (!try_enqueue(element)) {
+      throw std::overflow_error("QueueRingSPSC is full");
+    }
+  }
+
+  void enqueue(T &&element) {
+    if (!try_enqueue(std::move(element))) {
+      throw std::overflow_error("QueueRingSPSC is full");
+    }
+  }
+
+  /** @brief Consumer side. Throws std::out_of_range if empty. */
+  T dequeue() {
+    std::size_t head = consumer.head.load(std::memory_order_relaxed);
+    if (head == producer.tail.load(std::memory_order_acquire)) {
+      throw std::out_of_range("QueueRingSPSC is empty");
+    }
+    T &slot = slots[head & mask];
+    T element = std::move(slot);
+    slot.~T();
+    consumer.head.store(head + 1, std::memory_order_release);
+    return element;
+  }
+
+  /** @brief Consumer side. Throws std::out_of_range if empty. */
+  const T &peek() const {
+    std::size_t head = consumer.head.load(std::memory_order_relaxed);
+    if (head == producer.tail.load(std::memory_order_acquire)) {
+      throw std::out_of_range("QueueRingSPSC is empty");
+    }
+    return slots[head & mask];
+  }
+
+  bool isEmpty() const { return size() == 0; }
+
+  std::size_t size() const {
+    return producer.tail.load(std::memory_order_acquire) -
+           consumer.head.load(std::memory_order_acquire);
+  }
+
+  std::size_t capacity() const { return mask + 1; }
+
+private:
+  static constexpr std::size_t kCacheLine = 64;
+
+  struct alignas(kCacheLine) ProducerSide {
+    std::atomic<std::size_t> tail{0};
+    std::size_t cachedHead = 0;
+  };
+  struct alignas(kCacheLine) ConsumerSide {
+    std::atomic<std::size_t> head{0};
+    std::size_t cachedTail = 0;
+  };
+
+  ProducerSide producer;
+  ConsumerSide consumer;
+  alignas(kCacheLine) T *slots;
+  std::size_t mask;
+};
+
+#endif
@@ -3,8 +3,20 @@
 #ifndef A1_HPP
 #define A1_HPP
 #include <algorithm> // Included for use of std::swap()
+#include <array>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
-template <class T> int LinearSearch(T elements[], int nrOfElements, T element) {
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define A1_X86_SIMD 1
+#endif
+
+template <class T>
+int LinearSearchScalar(const T elements[], int nrOfElements, T element) {
   for (int i = 0; i < nrOfElements; i++) {
     if (element == elements[i]) {
       return i;
@@ -13,6 +25,198 @@ template <class T> int LinearSearch(T elements[], int nrOfElements, T element) {
   return -1;
 }
 
+#ifdef A1_X86_SIMD
+// Vectorized LinearSearch for arithmetic types: compare a whole register of
+// elements per instruction, OR four registers together so the loop branches
+// once per 4 vectors, and locate the first hit with movemask + tzcnt.
+// Floating point uses float compares so that -0.0 == 0.0 and NaN never
+// matches, exactly like the scalar loop.
+template <class T>
+__attribute__((target("sse2"))) inline __m128i EqualSse2(const T *elements,
+                                                        T element) {
+  if constexpr (std::is_same_v<T, float>) {
+    return _mm_castps_si128(
+        _mm_cmpeq_ps(_mm_loadu_ps(elements), _mm_set1_ps(element)));
+  } else if constexpr (std::is_same_v<T, double>) {
+    return _mm_castpd_si128(
+        _mm_cmpeq_pd(_mm_loadu_pd(elements), _mm_set1_pd(element)));
+  } else {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(elements));
+    if constexpr (sizeof(T) == 1) {
+      return _mm_cmpeq_epi8(v, _mm_set1_epi8(static_cast<char>(element)));
+    } else if constexpr (sizeof(T) == 2) {
+      return _mm_cmpeq_epi16(v, _mm_set1_epi16(static_cast<short>(element)));
+    } else if constexpr (sizeof(T) == 4) {
+      return _mm_cmpeq_epi32(v, _mm_set1_epi32(static_cast<int>(element)));
+    } else {
+      // SSE2 has no 64-bit compare: both 32-bit halves must match.
+      __m128i halves = _mm_cmpeq_epi32(
+          v, _mm_set1_epi64x(static_cast<long long>(element)));
+      return _mm_and_si128(halves,
+                           _mm_shuffle_epi32(halves, _MM_SHUFFLE(2, 3, 0, 1)));
+    }
+  }
+}
+
+template <class T>
+__attribute__((target("sse2"))) int
+LinearSearchSse2(const T elements[], int nrOfElements, T element) {
+  const int lanes = 16 / sizeof(T);
+  int i = 0;
+  for (; i + 4 * lanes <= nrOfElements; i += 4 * lanes) {
+    __m128i any = _mm_or_si128(
+        _mm_or_si128(EqualSse2(elements + i, element),
+                     EqualSse2(elements + i + lanes, element)),
+        _mm_or_si128(EqualSse2(elements + i + 2 * lanes, element),
+                     EqualSse2(elements + i + 3 * lanes, element)));
+    if (_mm_movemask_epi8(any)) {
+      break;
+    }
+  }
+  for (; i + lanes <= nrOfElements; i += lanes) {
+    int mask = _mm_movemask_epi8(EqualSse2(elements + i, element));
+    if (mask) {
+      return i + __builtin_ctz(mask) / static_cast<int>(sizeof(T));
+    }
+  }
+  int tail = LinearSearchScalar(elements + i, nrOfElements - i, element);
+  return tail < 0 ? -1 : i + tail;
+}
+
+template <class T>
+__attribute__((target("avx2"))) inline __m256i EqualAvx2(const T *elements,
+                                                        T element) {
+  if constexpr (std::is_same_v<T, float>) {
+    return _mm256_castps_si256(_mm256_cmp_ps(
+        _mm256_loadu_ps(elements), _mm256_set1_ps(element), _CMP_EQ_OQ));
+  } else if constexpr (std::is_same_v<T, double>) {
+    return _mm256_castpd_si256(_mm256_cmp_pd(
+        _mm256_loadu_pd(elements), _mm256_set1_pd(element), _CMP_EQ_OQ));
+  } else {
+    __m256i v =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(elements));
+    if constexpr (sizeof(T) == 1) {
+      return _mm256_cmpeq_epi8(v, _mm256_set1_epi8(static_cast<char>(element)));
+    } else if constexpr (sizeof(T) == 2) {
+      return _mm256_cmpeq_epi16(
+          v, _mm256_set1_epi16(static_cast<short>(element)));
+    } else if constexpr (sizeof(T) == 4) {
+      return _mm256_cmpeq_epi32(v,
+                                _mm256_set1_epi32(static_cast<int>(element)));
+    } else {
+      return _mm256_cmpeq_epi64(
+          v, _mm256_set1_epi64x(static_cast<long long>(element)));
+    }
+  }
+}
+
+template <class T>
+__attribute__((target("avx2"))) int
+LinearSearchAvx2(const T elements[], int nrOfElements, T element) {
+  const int lanes = 32 / sizeof(T);
+  int i = 0;
+  for (; i + 4 * lanes <= nrOfElements; i += 4 * lanes) {
+    __m256i any = _mm256_or_si256(
+        _mm256_or_si256(EqualAvx2(elements + i, element),
+                        EqualAvx2(elements + i + lanes, element)),
+        _mm256_or_si256(EqualAvx2(elements + i + 2 * lanes, element),
+                        EqualAvx2(elements + i + 3 * lanes, element)));
+    if (!_mm256_testz_si256(any, any)) {
+      break;
+    }
+  }
+  for (; i + lanes <= nrOfElements; i += lanes) {
+    unsigned mask = static_cast<unsigned>(
+        _mm256_movemask_epi8(EqualAvx2(elements + i, element)));
+    if (mask) {
+      return i + __builtin_ctz(mask) / static_cast<int>(sizeof(T));
+    }
+  }
+  int tail = LinearSearchScalar(elements + i, nrOfElements - i, element);
+  return tail < 0 ? -1 : i + tail;
+}
+
+// AVX-512 compares straight into a per-element mask register.
+template <class T>
+__attribute__((target("avx512f,avx512bw"))) inline unsigned long long
+EqualAvx512(const T *elements, T element) {
+  if constexpr (std::is_same_v<T, float>) {
+    return _mm512_cmp_ps_mask(_mm512_loadu_ps(elements),
+                              _mm512_set1_ps(element), _CMP_EQ_OQ);
+  } else if constexpr (std::is_same_v<T, double>) {
+    return _mm512_cmp_pd_mask(_mm512_loadu_pd(elements),
+                              _mm512_set1_pd(element), _CMP_EQ_OQ);
+  } else {
+    __m512i v = _mm512_loadu_si512(elements);
+    if constexpr (sizeof(T) == 1) {
+      return _mm512_cmpeq_epi8_mask(
+          v, _mm512_set1_epi8(static_cast<char>(element)));
+    } else if constexpr (sizeof(T) == 2) {
+      return _mm512_cmpeq_epi16_mask(
+          v, _mm512_set1_epi16(static_cast<short>(element)));
+    } else if constexpr (sizeof(T) == 4) {
+      return _mm512_cmpeq_epi32_mask(
+          v, _mm512_set1_epi32(static_cast<int>(element)));
+    } else {
+      return _mm512_cmpeq_epi64_mask(
+          v, _mm512_set1_epi64(static_cast<long long>(element)));
+    }
+  }
+}
+
+template <class T>
+__attribute__((target("avx512f,avx512bw"))) int
+LinearSearchAvx512(const T elements[], int nrOfElements, T element) {
+  const int lanes = 64 / sizeof(T);
+  int i = 0;
+  for (; i + 4 * lanes <= nrOfElements; i += 4 * lanes) {
+    if (EqualAvx512(elements + i, element) |
+        EqualAvx512(elements + i + lanes, element) |
+        EqualAvx512(elements + i + 2 * lanes, element) |
+        EqualAvx512(elements + i + 3 * lanes, element)) {
+      break;
+    }
+  }
+  for (; i + lanes <= nrOfElements; i += lanes) {
+    unsigned long long mask = EqualAvx512(elements + i, element);
+    if (mask) {
+      return i + __builtin_ctzll(mask);
+    }
+  }
+  int tail = LinearSearchScalar(elements + i, nrOfElements - i, element);
+  return tail < 0 ? -1 : i + tail;
+}
+#endif
+
+template <class T>
+using LinearSearchFunction = int (*)(const T[], int, T);
+
+// Picks the widest kernel the running CPU supports, once per element type.
+template <class T> LinearSearchFunction<T> SelectLinearSearch() {
+#ifdef A1_X86_SIMD
+  if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")) {
+    return LinearSearchAvx512<T>;
+  }
+  if (__builtin_cpu_supports("avx2")) {
+    return LinearSearchAvx2<T>;
+  }
+  if (__builtin_cpu_supports("sse2")) {
+    return LinearSearchSse2<T>;
+  }
+#endif
+  return LinearSearchScalar<T>;
+}
+
+template <class T> int LinearSearch(T elements[], int nrOfElements, T element) {
+  if constexpr (std::is_arithmetic_v<T> && !std::is_same_v<T, bool> &&
+                sizeof(T) <= 8) {
+    static const LinearSearchFunction<T> search = SelectLinearSearch<T>();
+    return search(elements, nrOfElements, element);
+  } else {
+    return LinearSearchScalar(elements, nrOfElements, element);
+  }
+}
+
 template <class T> void Selectionsort(T elements[], int nrOfElements) {
   for (int i = 0; i < nrOfElements - 1; i++) {
     int min = i;
@@ -25,19 +229,46 @@ template <class T> void Selectionsort(T elements[], int nrOfElements) {
   }
 }
 
+// Moves [first, last) to destination, which may overlap the source as long
+// as it starts before it. Trivially copyable types take a single memmove.
+template <class T> void MoveRange(T *first, T *last, T *destination) {
+  if constexpr (std::is_trivially_copyable_v<T>) {
+    if (first != last) {
+      std::memmove(static_cast<void *>(destination), first,
+                   (last - first) * sizeof(T));
+    }
+  } else {
+    std::move(first, last, destination);
+  }
+}
+
+// Moves [first, last) so that it ends at destinationLast, which may overlap
+// the source as long as it ends after it.
+template <class T>
+void MoveRangeBackward(T *first, T *last, T *destinationLast) {
+  if constexpr (std::is_trivially_copyable_v<T>) {
+    if (first != last) {
+      std::memmove(static_cast<void *>(destinationLast - (last - first)),
+                   first, (last - first) * sizeof(T));
+    }
+  } else {
+    std::move_backward(first, last, destinationLast);
+  }
+}
+
 template <class T> void Insertionsort(T elements[], int nrOfElements) {
   for (int i = 1; i < nrOfElements; i++) {
-    T element = elements[i];
+    T element = std::move(elements[i]);
     int j = i - 1;
     while (j >= 0) {
       if (element < elements[j]) {
-        elements[j + 1] = elements[j];
+        elements[j + 1] = std::move(elements[j]);
         j -= 1;
       } else {
         break;
       }
     }
-    elements[j + 1] = element;
+    elements[j + 1] = std::move(element);
   }
 }
 
@@ -88,37 +319,293 @@ int BinarySearchRecursive(T elements[], int nrOfElements, T element) {
   return BinarySearchRecurse(elements, element, 0, nrOfElements - 1);
 }
 
-template <class T> void BinaryInsertionsort(T elements[], int nrOfElements) {
-  for (int i = 1; i < nrOfElements; i++) {
-    T element = elements[i];
-    int placement = 0;
+// Allocator handing out storage aligned to a cache line.
+template <class T> struct CacheLineAllocator {
+  using value_type = T;
+  static constexpr std::size_t kAlignment = 64;
+
+  CacheLineAllocator() = default;
+  template <class U> CacheLineAllocator(const CacheLineAllocator<U> &) {}
+
+  T *allocate(std::size_t n) {
+    return static_cast<T *>(
+        ::operator new(n * sizeof(T), std::align_val_t(kAlignment)));
+  }
+  void deallocate(T *p, std::size_t) {
+    ::operator delete(p, std::align_val_t(kAlignment));
+  }
+  template <class U> bool operator==(const CacheLineAllocator<U> &) const {
+    return true;
+  }
+};
+
+// Search index over a static sorted array, stored in Eytzinger (BFS) order:
+// the children of slot k are 2k and 2k+1, and slot 0 is unused. The top of
+// the tree stays hot in cache and every probe is branch-free. All
+// descendants a few levels below a slot share one cache line, which is
+// prefetched while the levels above are still being compared. Results are
+// positions in the original sorted array, with BinarySearch's -1 for
+// missing keys.
+template <class T> class EytzingerIndex {
+public:
+  EytzingerIndex(const T elements[], int nrOfElements)
+      : layout(nrOfElements + 1), positions(nrOfElements + 1, -1),
+        nrOfElements(nrOfElements) {
+    int next = 0;
+    Build(elements, next, 1);
+    for (int n = nrOfElements; n > 0; n >>= 1) {
+      levels++;
+    }
+  }
+
+  int Search(const T &element) const {
+    int k = 1;
+    while (k <= nrOfElements) {
+      Prefetch(k);
+      k = 2 * k + (layout[k] < element);
+    }
+    return Resolve(k, element);
+  }
+
+  // Interleaves kBatch lookups level by level, so their cache misses
+  // overlap instead of being paid one after the other.
+  void SearchMany(const T keys[], int nrOfKeys, int out[]) const {
+    int k[kBatch];
+    for (int first = 0; first < nrOfKeys; first += kBatch) {
+      int batch = std::min(kBatch, nrOfKeys - first);
+      const T *batchKeys = keys + first;
+      for (int lane = 0; lane < batch; lane++) {
+        k[lane] = 1;
+      }
+      // Every slot above the last level exists, so no lane needs a check.
+      for (int level = 1; level < levels; level++) {
+        for (int lane = 0; lane < batch; lane++) {
+          Prefetch(k[lane]);
+          k[lane] = 2 * k[lane] + (layout[k[lane]] < batchKeys[lane]);
+        }
+      }
+      for (int lane = 0; lane < batch; lane++) {
+        int slot = std::min(k[lane], nrOfElements);
+        int step = 2 * k[lane] + (layout[slot] < batchKeys[lane]);
+        k[lane] = k[lane] <= nrOfElements ? step : k[lane];
+        out[first + lane] = Resolve(k[lane], batchKeys[lane]);
+      }
+    }
+  }
+
+  int size() const { return nrOfElements; }
+
+private:
+  static constexpr int kBatch = 16;
+  static constexpr int kSlotsPerLine =
+      sizeof(T) >= CacheLineAllocator<T>::kAlignment
+          ? 1
+          : static_cast<int>(CacheLineAllocator<T>::kAlignment / sizeof(T));
+
+  void Build(const T elements[], int &next, int k) {
+    if (k <= nrOfElements) {
+      Build(elements, next, 2 * k);
+      layout[k] = elements[next];
+      positions[k] = next++;
+      Build(elements, next, 2 * k + 1);
+    }
+  }
+
+  void Prefetch(int k) const {
+    long ahead = static_cast<long>(k) * kSlotsPerLine;
+    if (ahead <= nrOfElements) {
+      __builtin_prefetch(layout.data() + ahead);
+    }
+  }
+
+  // k fell off the tree; dropping the trailing right turns and the final
+  // left turn yields the slot of the first key not less than the target.
+  int Resolve(int k, const T &element) const {
+    k >>= __builtin_ffs(~k);
+    if (k == 0 || !(layout[k] == element)) {
+      return -1;
+    }
+    return positions[k];
+  }
+
+  std::vector<T, CacheLineAllocator<T>> layout;
+  std::vector<int> positions;
+  int nrOfElements;
+  int levels = 0;
+};
+
+template <class T>
+void BinarySearchMany(const EytzingerIndex<T> &index, const T keys[],
+                      int nrOfKeys, int out[]) {
+  index.SearchMany(keys, nrOfKeys, out);
+}
+
+// Extends the already sorted prefix elements[0, nrOfSorted) to the whole
+// array. Each element goes after any equal ones, so the sort is stable.
+template <class T>
+void BinaryInsertionsort(T elements[], int nrOfElements, int nrOfSorted) {
+  for (int i = std::max(nrOfSorted, 1); i < nrOfElements; i++) {
+    T element = std::move(elements[i]);
     int start = 0;
     int stop = i - 1;
-    while (true) {
+    while (start <= stop) {
       int center = (start + stop) / 2;
-      if (start > stop) {
-        placement = center + 1;
-        break;
-      }
-      if (elements[center] == element) {
-        placement = center;
-        break;
+      if (element < elements[center]) {
+        stop = center - 1;
+      } else {
+        start = center + 1;
       }
+    }
+    int placement = start;
+    MoveRangeBackward(elements + placement, elements + i, elements + i + 1);
+    elements[placement] = std::move(element);
+  }
+}
 
-      if (elements[center] < element) {
-        start = center + 1;
-      } else {
-        stop = center - 1;
+template <class T> void BinaryInsertionsort(T elements[], int nrOfElements) {
+  BinaryInsertionsort(elements, nrOfElements, 1);
+}
+
+const int kMaxSortingNetwork = 32;
+
+// Compare-exchanges (first + t, first + t + distance) for t < length. The
+// pairs of a run never overlap, so a run is two contiguous min/max sweeps
+// the compiler can turn into vector instructions.
+struct SortingNetworkRun {
+  int first;
+  int distance;
+  int length;
+};
+
+// Batcher's odd-even merge sort on N inputs, built at compile time and
+// packed into runs. Its 5/19/63/191 comparators for N = 4/8/16/32 are
+// optimal or within a few percent of the best known networks. All runs of
+// one (p, k) layer touch disjoint elements; runs are never merged across
+// layers.
+template <int N> struct SortingNetworkPlan {
+  static constexpr auto Generate() {
+    std::array<SortingNetworkRun, N * N + 1> runs{};
+    int count = 0;
+    for (int p = 1; p < N; p <<= 1) {
+      for (int k = p; k >= 1; k >>= 1) {
+        int layerStart = count;
+        for (int j = k % p; j + k < N; j += 2 * k) {
+          for (int i = 0; i < k && i + j + k < N; i++) {
+            if ((i + j) / (2 * p) != (i + j + k) / (2 * p)) {
+              continue;
+            }
+            SortingNetworkRun &last = runs[count > 0 ? count - 1 : 0];
+            if (count > layerStart && last.first + last.length == i + j) {
+              last.length++;
+            } else {
+              runs[count++] = SortingNetworkRun{i + j, k, 1};
+            }
+          }
+        }
       }
     }
-    for (int j = placement; j < i; j++) {
-      elements[j + 1] = elements[j];
+    return std::pair{runs, count};
+  }
+
+  static constexpr auto Runs() {
+    constexpr auto generated = Generate();
+    std::array<SortingNetworkRun, generated.second> runs{};
+    for (int i = 0; i < generated.second; i++) {
+      runs[i] = generated.first[i];
     }
-    elements[placement] = element;
+    return runs;
+  }
+
+  static constexpr auto kRuns = Runs();
+};
+
+// Branchless for arithmetic types: both outputs are selects on one compare,
+// which become cmov or vector min/max.
+template <class T> inline void CompareExchange(T &a, T &b) {
+  if constexpr (std::is_arithmetic_v<T>) {
+    bool swap = b < a;
+    T low = swap ? b : a;
+    T high = swap ? a : b;
+    a = low;
+    b = high;
+  } else if (b < a) {
+    std::swap(a, b);
+  }
+}
+
+template <int First, int Distance, int Length, class T>
+inline void CompareExchangeRun(T elements[]) {
+  for (int t = 0; t < Length; t++) {
+    CompareExchange(elements[First + t], elements[First + Distance + t]);
+  }
+}
+
+// Sorts exactly N elements with a fixed sequence of compare-exchanges. Not
+// stable.
+template <int N, class T> void SortingNetwork(T elements[]) {
+  using Plan = SortingNetworkPlan<N>;
+  [elements]<std::size_t... R>(std::index_sequence<R...>) {
+    (CompareExchangeRun<Plan::kRuns[R].first, Plan::kRuns[R].distance,
+                        Plan::kRuns[R].length>(elements),
+     ...);
+  }(std::make_index_sequence<Plan::kRuns.size()>());
+}
+
+template <class T> using SmallSortFunction = void (*)(T[]);
+
+template <class T, std::size_t... N>
+constexpr std::array<SmallSortFunction<T>, sizeof...(N)>
+MakeSortingNetworks(std::index_sequence<N...>) {
+  return {SortingNetwork<static_cast<int>(N), T>...};
+}
+
+// Sorts up to kMaxSortingNetwork elements with the network for that size,
+// falling back to Insertionsort above it. Not stable.
+template <class T> void SortingNetworkSort(T elements[], int nrOfElements) {
+  static constexpr auto networks = MakeSortingNetworks<T>(
+      std::make_index_sequence<kMaxSortingNetwork + 1>());
+  if (nrOfElements > kMaxSortingNetwork) {
+    Insertionsort(elements, nrOfElements);
+  } else if (nrOfElements > 1) {
+    networks[nrOfElements](elements);
   }
 }
 #endif
 
+#ifndef A1_NO_MAIN
+#include <iostream>
+
+#ifdef A1_X86_SIMD
+#include <x86intrin.h>
+
+// Bytes scanned per TSC cycle by the dispatched LinearSearch and by the
+// scalar loop, searching for a key that is not there.
+template <class T> void BenchmarkLinearSearch(const char *name) {
+  const int nrOfElements = 1 << 16;
+  const int repetitions = 200;
+  std::vector<T> elements(nrOfElements);
+  for (int i = 0; i < nrOfElements; i++) {
+    elements[i] = static_cast<T>(i % 100);
+  }
+  const T missing = static_cast<T>(101);
+
+  volatile int sink = 0;
+  unsigned long long start = __rdtsc();
+  for (int r = 0; r < repetitions; r++) {
+    sink = sink + LinearSearch(elements.data(), nrOfElements, missing);
+  }
+  unsigned long long simdCycles = __rdtsc() - start;
+  start = __rdtsc();
+  for (int r = 0; r < repetitions; r++) {
+    sink = sink + LinearSearchScalar(elements.data(), nrOfElements, missing);
+  }
+  unsigned long long scalarCycles = __rdtsc() - start;
+
+  double bytes = double(nrOfElements) * sizeof(T) * repetitions;
+  std::cout << name << ": simd " << bytes / simdCycles << " B/cycle, scalar "
+            << bytes / scalarCycles << " B/cycle\n";
+}
+#endif
 
 int main() {
   const int size = 7;
@@ -126,4 +613,14 @@ int main() {
   int idxes[size] = {0, 1, 2, 3, 4, 5, 6};
 
   BinaryInsertionsort(arr, size);
+
+#ifdef A1_X86_SIMD
+  BenchmarkLinearSearch<char>("int8");
+  BenchmarkLinearSearch<short>("int16");
+  BenchmarkLinearSearch<int>("int32");
+  BenchmarkLinearSearch<long long>("int64");
+  BenchmarkLinearSearch<float>("float");
+  BenchmarkLinearSearch<double>("double");
+#endif
 }
+#endif
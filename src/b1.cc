@@ -1,5 +1,9 @@
+#include "../impls/NodePool.hpp"
 #include "../impls/QueueArray.hpp"
 #include "../impls/QueueLinkedList.hpp"
+#include "../impls/QueueNodeList.hpp"
+#include "../impls/QueueRingMPMC.hpp"
+#include "../impls/QueueRingSPSC.hpp"
 #include "../impls/QueueStack.hpp"
 #include "../impls/StackArray.hpp"
 #include "../impls/StackLinkedList.hpp"
@@ -25,6 +29,38 @@ int main() {
                                             dequeue, peek, FirstInFirstOut);
   test_adt(qsll, &options);
 
+  // The same node queue with and without pooling; the harness prints the
+  // allocator calls per operation of each.
+  using QueueNodeHeap =
+      QueueNodeList<TrackedItem, CountingAllocator<TrackedItem>>;
+  using QueueNodePool = QueueNodeList<TrackedItem, PoolAllocator<TrackedItem>>;
+  using QueueNodeThreadPool =
+      QueueNodeList<TrackedItem, ThreadLocalPoolAllocator<TrackedItem>>;
+  adtOperations *qnh = CREATE_ADT_OPERATIONS(QueueNodeHeap, enqueue, dequeue,
+                                             peek, FirstInFirstOut);
+  test_adt(qnh, &options);
+  adtOperations *qnp = CREATE_ADT_OPERATIONS(QueueNodePool, enqueue, dequeue,
+                                             peek, FirstInFirstOut);
+  test_adt(qnp, &options);
+  adtOperations *qntp = CREATE_ADT_OPERATIONS(
+      QueueNodeThreadPool, enqueue, dequeue, peek, FirstInFirstOut);
+  test_adt(qntp, &options);
+
+  adtOperations *qspsc = CREATE_ADT_OPERATIONS(
+      QueueRingSPSC<TrackedItem>, enqueue, dequeue, peek, FirstInFirstOut);
+  test_adt(qspsc, &options);
+  adtConcurrentTestingOptions spsc_options =
+      default_adtConcurrentTestingOptions((char *)"QueueRingSPSC");
+  spsc_options.thread_counts_size = 1; // one producer, one consumer
+  test_adt_concurrent(qspsc, &spsc_options);
+
+  adtOperations *qmpmc = CREATE_ADT_OPERATIONS(
+      QueueRingMPMC<TrackedItem>, enqueue, dequeue, peek, FirstInFirstOut);
+  test_adt(qmpmc, &options);
+  adtConcurrentTestingOptions mpmc_options =
+      default_adtConcurrentTestingOptions((char *)"QueueRingMPMC");
+  test_adt_concurrent(qmpmc, &mpmc_options);
+
   QueueStacks<int> queue=QueueStacks<int>();
   queue.enqueue(1);
 }
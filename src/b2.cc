@@ -1,16 +1,106 @@
+#include "../impls/BPlusTree.hpp"
+#include "../impls/DaryHeap.hpp"
 #include "../impls/Heap.hpp"
 #include "../impls/HeapList.hpp"
 #include "../impls/IndexedList.hpp"
+#include "../impls/MultiQueue.hpp"
 #include "../impls/OrderedList.hpp"
 #include "../impls/PriorityQueueHeap.hpp"
 #include "../impls/PriorityQueueOrderdList.hpp"
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
 #include <testing>
+#include <vector>
+
+template <class HeapType>
+void BenchmarkHeap(const char *name, const std::vector<int> &keys) {
+  HeapType heap;
+  auto start = std::chrono::steady_clock::now();
+  for (int key : keys) {
+    heap.insert(key);
+  }
+  long long sum = 0;
+  for (std::size_t i = 0; i < keys.size(); i++) {
+    sum += heap.extract();
+  }
+  std::chrono::duration<double, std::nano> elapsed =
+      std::chrono::steady_clock::now() - start;
+  std::cout << name << " n=" << keys.size() << ": "
+            << elapsed.count() / keys.size() << " ns/element (checksum "
+            << sum << ")\n";
+}
+
+template <std::size_t D> void BenchmarkDaryBuild(const std::vector<int> &keys) {
+  std::vector<int> copy = keys;
+  DaryHeap<int, D> heap;
+  auto start = std::chrono::steady_clock::now();
+  heap.build(copy.data(), copy.size());
+  std::chrono::duration<double, std::nano> elapsed =
+      std::chrono::steady_clock::now() - start;
+  std::cout << "DaryHeap<" << D << "> build n=" << keys.size() << ": "
+            << elapsed.count() / keys.size() << " ns/element\n";
+}
+
+// Runs the harness benchmark over every input distribution. The ordered
+// lists are quadratic to fill, which caps n. Results are appended to csvPath
+// unless it is null.
+void BenchmarkOrdered(adtOperations *ops, const char *name,
+                      const char *csvPath) {
+  static int sizes[] = {1000, 10000};
+  adtSimpleTestingOptions options =
+      default_adtSimpleTestingOptions(name);
+  options.input_sizes = sizes;
+  options.input_sizes_size = sizeof(sizes) / sizeof(int);
+  options.benchmark = true;
+  options.benchmark_all_inputs = true;
+  options.benchmark_csv_path = csvPath;
+  test_adt(ops, &options);
+}
+
+struct StrictMultiQueue : MultiQueue<TrackedItem> {
+  StrictMultiQueue() : MultiQueue(DefaultQueueCount(), Ordering::Strict) {}
+};
+
+void BenchmarkHeaps() {
+  std::mt19937 rng(42);
+  for (int n = 1000; n <= 10000000; n *= 10) {
+    std::vector<int> keys(n);
+    for (int &key : keys) {
+      key = static_cast<int>(rng());
+    }
+    BenchmarkHeap<Heap<int>>("Heap", keys);
+    BenchmarkHeap<DaryHeap<int, 2>>("DaryHeap<2>", keys);
+    BenchmarkHeap<DaryHeap<int, 4>>("DaryHeap<4>", keys);
+    BenchmarkHeap<DaryHeap<int, 8>>("DaryHeap<8>", keys);
+    BenchmarkHeap<DaryHeap<int, 4, std::less<int>, false>>(
+        "DaryHeap<4> no handles", keys);
+    BenchmarkHeap<DaryHeap<int, 8, std::less<int>, false>>(
+        "DaryHeap<8> no handles", keys);
+    BenchmarkDaryBuild<4>(keys);
+    BenchmarkDaryBuild<8>(keys);
+  }
+}
+
+int main(int argc, char **argv) {
+  const char *orderedCsvPath = nullptr;
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--ordered-csv" && i + 1 < argc) {
+      orderedCsvPath = argv[++i];
+    } else {
+      std::fprintf(stderr, "usage: %s [--ordered-csv PATH]\n", argv[0]);
+      return 2;
+    }
+  }
 
-int main() {
   adtSimpleTestingOptions options =
       default_adtSimpleTestingOptions((char *)"testing");
   adtOperations *sll =
-      CREATE_ADT_OPERATIONS(Heap<TrackedItem>, insert, extract, peek, Sorted);
+      CREATE_ADT_OPERATIONS(Heap<TrackedItem>, insert, extract, peek, SortedValue);
   test_adt(sll, &options);
 
   adtOperations *hl = CREATE_ADT_OPERATIONS(HeapList<TrackedItem>, insert,
@@ -21,12 +111,44 @@ int main() {
   test_adt(il, &options);
 
   adtOperations *ol = CREATE_ADT_OPERATIONS(OrderedList<TrackedItem>, add,
-                                            removeFirst, first, Unkown);
+                                            removeFirst, first, Unknown);
   test_adt(ol, &options);
+  adtOperations *bpt = CREATE_ADT_OPERATIONS(BPlusTree<TrackedItem>, add,
+                                             removeFirst, first, SortedValue);
+  test_adt(bpt, &options);
+  BenchmarkOrdered(bpt, "BPlusTree", orderedCsvPath);
+  BenchmarkOrdered(ol, "OrderedList", orderedCsvPath);
+  BenchmarkOrdered(il, "IndexedList", orderedCsvPath);
+
   adtOperations *pqh = CREATE_ADT_OPERATIONS(PriorityQueueHeap<TrackedItem>,
-                                             enqueue, dequeue, peek, Unkown);
+                                             enqueue, dequeue, peek, Unknown);
   test_adt(pqh, &options);
   adtOperations *pqol = CREATE_ADT_OPERATIONS(
-      PriorityQueueOrderedList<TrackedItem>, enqueue, dequeue, peek, Unkown);
+      PriorityQueueOrderedList<TrackedItem>, enqueue, dequeue, peek, Unknown);
   test_adt(pqol, &options);
+
+  adtOperations *dh = CREATE_ADT_OPERATIONS(DaryHeap<TrackedItem>, insert,
+                                            extract, peek, SortedValue);
+  test_adt(dh, &options);
+
+  int thread_counts[] = {1, 2, 4, 8, 16, 32, 64};
+  adtOperations *mq = CREATE_ADT_OPERATIONS(MultiQueue<TrackedItem>, insert,
+                                            extract, peek, Unknown);
+  test_adt(mq, &options);
+  adtConcurrentTestingOptions mq_options =
+      default_adtConcurrentTestingOptions((char *)"MultiQueue");
+  mq_options.thread_counts = thread_counts;
+  mq_options.thread_counts_size = sizeof(thread_counts) / sizeof(int);
+  mq_options.items_per_producer = 20000;
+  mq_options.order = SortedValue;
+  test_adt_concurrent(mq, &mq_options);
+
+  adtOperations *smq = CREATE_ADT_OPERATIONS(StrictMultiQueue, insert, extract,
+                                             peek, SortedValue);
+  test_adt(smq, &options);
+  adtConcurrentTestingOptions smq_options = mq_options;
+  smq_options.name = (char *)"MultiQueue strict";
+  test_adt_concurrent(smq, &smq_options);
+
+  BenchmarkHeaps();
 }
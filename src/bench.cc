@@ -0,0 +1,382 @@
+#define A2_NO_MAIN
+#include "a2.cc"
+
+#include "../impls/BPlusTree.hpp"
+#include "../impls/DaryHeap.hpp"
+#include "../impls/MultiQueue.hpp"
+#include "../impls/QueueRingMPMC.hpp"
+#include "../impls/QueueRingSPSC.hpp"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <testing>
+
+// Regression benchmark behind `zig build bench`: every sort, search and ADT
+// over the harness input distributions. Each result is the best ns per
+// operation over several repetitions, which is far steadier than the mean.
+// Results are compared with a JSON baseline and the run fails if any got
+// slower by more than the threshold; without a baseline, or with --update,
+// the run becomes the new baseline.
+
+struct BenchResult {
+  std::string name;
+  std::string distribution;
+  int n;
+  double nsPerOp;
+};
+
+const int kBenchSizes[] = {1 << 10, 1 << 14, 1 << 18};
+const int kQuadraticMaxSize = 1 << 14;
+const int kMinRepetitions = 3;
+const int kMaxRepetitions = 50;
+const double kMinMeasureNs = 20e6;
+const unsigned long long kBenchSeed = 1;
+
+volatile long long benchSink = 0;
+
+// Calls prepare() untimed and timed() timed until both a minimum count and
+// a minimum total time are reached, and returns the best time per op.
+template <class Prepare, class Timed>
+double BestNsPerOp(long long operations, Prepare prepare, Timed timed) {
+  double best = std::numeric_limits<double>::infinity();
+  double total = 0;
+  for (int repetition = 0;
+       repetition < kMinRepetitions ||
+       (total < kMinMeasureNs && repetition < kMaxRepetitions);
+       repetition++) {
+    prepare();
+    auto start = std::chrono::steady_clock::now();
+    timed();
+    double ns = std::chrono::duration<double, std::nano>(
+                    std::chrono::steady_clock::now() - start)
+                    .count();
+    best = std::min(best, ns);
+    total += ns;
+  }
+  return best / static_cast<double>(std::max(operations, 1LL));
+}
+
+class Bench {
+public:
+  void Run() {
+    for (int d = 0; d < InputDistributionCount; d++) {
+      InputDistribution distribution = static_cast<InputDistribution>(d);
+      if (distribution == InputEmpty) {
+        continue;
+      }
+      for (int n : kBenchSizes) {
+        std::vector<int> input(n);
+        int generated = generate_input_values(distribution, n, kBenchSeed,
+                                              input.data());
+        if (generated != n) {
+          throw std::runtime_error("input generation failed");
+        }
+        current = input_distribution_name(distribution);
+        RunSorts(input);
+        RunSearches(input);
+        RunAdts(input);
+      }
+    }
+  }
+
+  const std::vector<BenchResult> &Results() const { return results; }
+
+private:
+  void Record(const char *name, int n, double nsPerOp) {
+    results.push_back(BenchResult{name, current, n, nsPerOp});
+    std::printf("%-28s %-20s n=%-8d %10.2f ns/op\n", name, current.c_str(), n,
+                nsPerOp);
+  }
+
+  template <class SortFunction>
+  void Sort(const char *name, const std::vector<int> &input,
+            SortFunction sort) {
+    std::vector<int> elements;
+    int n = static_cast<int>(input.size());
+    Record(name, n,
+           BestNsPerOp(
+               n, [&] { elements = input; },
+               [&] { sort(elements.data(), n); }));
+    if (!std::is_sorted(elements.begin(), elements.end())) {
+      throw std::runtime_error(std::string(name) + " did not sort");
+    }
+  }
+
+  void RunSorts(const std::vector<int> &input) {
+    if (static_cast<int>(input.size()) <= kQuadraticMaxSize) {
+      Sort("Selectionsort", input,
+           [](int *e, int n) { Selectionsort(e, n); });
+      Sort("Insertionsort", input,
+           [](int *e, int n) { Insertionsort(e, n); });
+      Sort("BinaryInsertionsort", input,
+           [](int *e, int n) { BinaryInsertionsort(e, n); });
+      // Last-element pivot: quadratic, and recursing n deep, on sorted and
+      // all-equal inputs.
+      Sort("QuicksortLomuto", input,
+           [](int *e, int n) { QuicksortLomuto(e, n); });
+    }
+    Sort("std::sort", input, [](int *e, int n) { std::sort(e, e + n); });
+    Sort("Mergesort", input, [](int *e, int n) { Mergesort(e, n); });
+    Sort("MergesortBook", input, [](int *e, int n) { MergesortBook(e, n); });
+    Sort("QuicksortHoareImproved", input,
+         [](int *e, int n) { QuicksortHoareImproved(e, n); });
+    Sort("Introsort", input,
+         [](int *e, int n) { QuicksortHoareImprovedMedian3(e, n); });
+    // A fixed thread count keeps the numbers comparable across machines.
+    Sort("ParallelSamplesort", input, [](int *e, int n) {
+      SamplesortOptions options;
+      options.nrOfThreads = 4;
+      ParallelSamplesort(e, n, options);
+    });
+    Sort("Heapsort", input, [](int *e, int n) { Heapsort(e, n); });
+    Sort("Powersort", input, [](int *e, int n) { Powersort(e, n); });
+    Sort("RadixsortLSD", input, [](int *e, int n) { RadixsortLSD(e, n); });
+    Sort("RadixsortMSD", input, [](int *e, int n) { RadixsortMSD(e, n); });
+    // Sorted blocks of 32 followed by a merge, so the result is checkable.
+    Sort("SortingNetworkSort", input, [](int *e, int n) {
+      for (int i = 0; i < n; i += kMaxSortingNetwork) {
+        SortingNetworkSort(e + i, std::min(kMaxSortingNetwork, n - i));
+      }
+      for (int width = kMaxSortingNetwork; width < n; width *= 2) {
+        for (int i = 0; i + width < n; i += 2 * width) {
+          std::inplace_merge(e + i, e + i + width,
+                             e + std::min(n, i + 2 * width));
+        }
+      }
+    });
+  }
+
+  // Keys are the input values themselves, in input order, so every lookup
+  // hits and the distribution decides how the probes spread.
+  void RunSearches(const std::vector<int> &input) {
+    std::vector<int> sorted = input;
+    std::sort(sorted.begin(), sorted.end());
+    int n = static_cast<int>(sorted.size());
+    auto search = [&](const char *name, int queries, auto lookup) {
+      Record(name, n, BestNsPerOp(
+                          queries, [] {},
+                          [&] {
+                            long long sum = 0;
+                            for (int q = 0; q < queries; q++) {
+                              sum += lookup(input[q % n]);
+                            }
+                            benchSink = benchSink + sum;
+                          }));
+    };
+    search("LinearSearch", 256,
+           [&](int key) { return LinearSearch(sorted.data(), n, key); });
+    search("BinarySearch", 1 << 16,
+           [&](int key) { return BinarySearch(sorted.data(), n, key); });
+    EytzingerIndex<int> index(sorted.data(), n);
+    search("EytzingerIndex::Search", 1 << 16,
+           [&](int key) { return index.Search(key); });
+
+    const int queries = 1 << 16;
+    std::vector<int> keys(queries), out(queries);
+    for (int q = 0; q < queries; q++) {
+      keys[q] = input[q % n];
+    }
+    Record("BinarySearchMany", n,
+           BestNsPerOp(
+               queries, [] {},
+               [&] {
+                 BinarySearchMany(index, keys.data(), queries, out.data());
+                 benchSink = benchSink + out[queries - 1];
+               }));
+  }
+
+  // Fills the structure with every input value and empties it again; the
+  // result is per element, insert and remove together.
+  template <class Adt, class Insert, class Remove>
+  void FillAndDrain(const char *name, const std::vector<int> &input,
+                    Insert insert, Remove remove) {
+    int n = static_cast<int>(input.size());
+    Record(name, n, BestNsPerOp(
+                        n, [] {},
+                        [&] {
+                          Adt adt;
+                          for (int value : input) {
+                            insert(adt, value);
+                          }
+                          long long sum = 0;
+                          for (int i = 0; i < n; i++) {
+                            sum += remove(adt);
+                          }
+                          benchSink = benchSink + sum;
+                        }));
+  }
+
+  void RunAdts(const std::vector<int> &input) {
+    auto insert = [](auto &adt, int value) { adt.insert(value); };
+    auto extract = [](auto &adt) { return adt.extract(); };
+    FillAndDrain<DaryHeap<int>>("DaryHeap<4>", input, insert, extract);
+    FillAndDrain<DaryHeap<int, 4, std::less<int>, false>>(
+        "DaryHeap<4> no handles", input, insert, extract);
+    FillAndDrain<MultiQueue<int>>("MultiQueue", input, insert, extract);
+    FillAndDrain<BPlusTree<int>>(
+        "BPlusTree", input, [](auto &adt, int value) { adt.add(value); },
+        [](auto &adt) { return adt.removeFirst(); });
+
+    struct SpscQueue : QueueRingSPSC<int> {
+      SpscQueue() : QueueRingSPSC<int>(kBenchSizes[2]) {}
+    };
+    struct MpmcQueue : QueueRingMPMC<int> {
+      MpmcQueue() : QueueRingMPMC<int>(kBenchSizes[2]) {}
+    };
+    auto enqueue = [](auto &adt, int value) { adt.enqueue(value); };
+    auto dequeue = [](auto &adt) { return adt.dequeue(); };
+    FillAndDrain<SpscQueue>("QueueRingSPSC", input, enqueue, dequeue);
+    FillAndDrain<MpmcQueue>("QueueRingMPMC", input, enqueue, dequeue);
+
+    std::vector<int> sorted = input;
+    std::sort(sorted.begin(), sorted.end());
+    std::vector<int> items;
+    BPlusTree<int> tree;
+    int n = static_cast<int>(sorted.size());
+    Record("BPlusTree::bulk_load", n,
+           BestNsPerOp(
+               n, [&] { items = sorted; },
+               [&] { tree.bulk_load(items.data(), n); }));
+  }
+
+  std::vector<BenchResult> results;
+  std::string current;
+};
+
+std::string ResultKey(const BenchResult &result) {
+  return result.name + "|" + result.distribution + "|" +
+         std::to_string(result.n);
+}
+
+// One object per line, so the file diffs well and reads back line by line.
+void WriteBaseline(const std::string &path,
+                   const std::vector<BenchResult> &results) {
+  std::filesystem::path parent = std::filesystem::path(path).parent_path();
+  if (!parent.empty()) {
+    std::filesystem::create_directories(parent);
+  }
+  std::ofstream out(path);
+  if (!out) {
+    throw std::runtime_error("cannot write " + path);
+  }
+  out << "[\n";
+  for (std::size_t i = 0; i < results.size(); i++) {
+    const BenchResult &r = results[i];
+    char nsPerOp[32];
+    std::snprintf(nsPerOp, sizeof(nsPerOp), "%.4f", r.nsPerOp);
+    out << "  {\"name\": \"" << r.name << "\", \"distribution\": \""
+        << r.distribution << "\", \"n\": " << r.n
+        << ", \"ns_per_op\": " << nsPerOp << "}"
+        << (i + 1 < results.size() ? ",\n" : "\n");
+  }
+  out << "]\n";
+}
+
+// Reads back what WriteBaseline wrote; lines that do not parse are skipped.
+bool ReadBaseline(const std::string &path,
+                  std::map<std::string, BenchResult> &baseline) {
+  std::ifstream in(path);
+  if (!in) {
+    return false;
+  }
+  auto field = [](const std::string &line, const std::string &name) {
+    std::size_t at = line.find("\"" + name + "\": ");
+    if (at == std::string::npos) {
+      return std::string();
+    }
+    at += name.size() + 4;
+    if (line[at] == '"') {
+      return line.substr(at + 1, line.find('"', at + 1) - at - 1);
+    }
+    return line.substr(at, line.find_first_of(",}", at) - at);
+  };
+  std::string line;
+  while (std::getline(in, line)) {
+    BenchResult result{field(line, "name"), field(line, "distribution"), 0, 0};
+    std::string n = field(line, "n");
+    std::string ns = field(line, "ns_per_op");
+    if (result.name.empty() || n.empty() || ns.empty()) {
+      continue;
+    }
+    result.n = std::atoi(n.c_str());
+    result.nsPerOp = std::atof(ns.c_str());
+    baseline[ResultKey(result)] = result;
+  }
+  return true;
+}
+
+// Returns the number of results more than thresholdPercent slower than
+// their baseline entry.
+int Compare(const std::vector<BenchResult> &results,
+            const std::map<std::string, BenchResult> &baseline,
+            double thresholdPercent) {
+  int regressions = 0;
+  for (const BenchResult &result : results) {
+    auto entry = baseline.find(ResultKey(result));
+    if (entry == baseline.end() || entry->second.nsPerOp <= 0) {
+      std::printf("new        %s\n", ResultKey(result).c_str());
+      continue;
+    }
+    double change =
+        100.0 * (result.nsPerOp - entry->second.nsPerOp) / entry->second.nsPerOp;
+    if (change > thresholdPercent) {
+      regressions++;
+      std::printf("REGRESSION %s: %.2f -> %.2f ns/op (%+.1f%%)\n",
+                  ResultKey(result).c_str(), entry->second.nsPerOp,
+                  result.nsPerOp, change);
+    } else if (change < -thresholdPercent) {
+      std::printf("faster     %s: %.2f -> %.2f ns/op (%+.1f%%)\n",
+                  ResultKey(result).c_str(), entry->second.nsPerOp,
+                  result.nsPerOp, change);
+    }
+  }
+  return regressions;
+}
+
+int main(int argc, char **argv) {
+  std::string baselinePath = "bench/baseline.json";
+  double thresholdPercent = 10;
+  bool update = false;
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--baseline" && i + 1 < argc) {
+      baselinePath = argv[++i];
+    } else if (arg == "--threshold" && i + 1 < argc) {
+      thresholdPercent = std::atof(argv[++i]);
+    } else if (arg == "--update") {
+      update = true;
+    } else {
+      std::fprintf(stderr,
+                   "usage: %s [--baseline PATH] [--threshold PERCENT] "
+                   "[--update]\n",
+                   argv[0]);
+      return 2;
+    }
+  }
+
+  Bench bench;
+  try {
+    bench.Run();
+  } catch (const std::exception &error) {
+    std::fprintf(stderr, "bench failed: %s\n", error.what());
+    return 2;
+  }
+
+  std::map<std::string, BenchResult> baseline;
+  if (update || !ReadBaseline(baselinePath, baseline)) {
+    WriteBaseline(baselinePath, bench.Results());
+    std::printf("Wrote baseline %s (%zu results)\n", baselinePath.c_str(),
+                bench.Results().size());
+    return 0;
+  }
+  int regressions = Compare(bench.Results(), baseline, thresholdPercent);
+  std::printf("%d of %zu results regressed by more than %.1f%% against %s\n",
+              regressions, bench.Results().size(), thresholdPercent,
+              baselinePath.c_str());
+  return regressions == 0 ? 0 : 1;
+}
@@ -0,0 +1,403 @@
+const std = @import("std");
+const c = @cImport({
+    @cInclude("testing");
+});
+const errors = @import("error.zig");
+const logging = @import("logging.zig");
+const adt = @import("adt_simple.zig");
+const test_results = @import("test_results.zig");
+
+const ADTSimple = adt.ADTSimple;
+const ADTSimpleBuilder = adt.ADTSimpleBuilder;
+const TestCaseResult = test_results.TestCaseResult;
+const Allocator = std.mem.Allocator;
+
+pub const ConcurrentCaseConfig = struct {
+    name: []const u8,
+    producers: usize = 1,
+    consumers: usize = 1,
+    items_per_producer: usize = 100_000,
+};
+
+/// State shared by every producer and consumer thread of one case.
+const SharedState = struct {
+    adt: ADTSimple,
+    config: ConcurrentCaseConfig,
+    start: std.atomic.Value(bool) = std.atomic.Value(bool).init(false),
+    failed: std.atomic.Value(bool) = std.atomic.Value(bool).init(false),
+    consumed: std.atomic.Value(usize) = std.atomic.Value(usize).init(0),
+    order_violations: std.atomic.Value(usize) = std.atomic.Value(usize).init(0),
+    /// One row of `config.producers` entries per consumer: the last order
+    /// that consumer saw from each producer.
+    last_orders: []i32,
+
+    fn total(self: *const SharedState) usize {
+        return self.config.producers * self.config.items_per_producer;
+    }
+
+    fn waitForStart(self: *SharedState) void {
+        while (!self.start.load(.acquire)) std.atomic.spinLoopHint();
+    }
+};
+
+/// Producer `p` enqueues items with value = p and order = 0, 1, 2, ...
+/// A full queue is not an error, the producer yields and retries.
+fn producerMain(state: *SharedState, producer: usize) void {
+    state.waitForStart();
+    var sequence: usize = 0;
+    while (sequence < state.config.items_per_producer) {
+        if (state.failed.load(.monotonic)) return;
+        const item = c.CTrackedItem{ .value = @intCast(producer), .order = @intCast(sequence) };
+        state.adt.insertValue(item) catch |err| {
+            if (err == errors.AdtError.Full) {
+                std.Thread.yield() catch {};
+                continue;
+            }
+            state.failed.store(true, .monotonic);
+            return;
+        };
+        sequence += 1;
+    }
+}
+
+/// Consumers drain until every produced item is accounted for. Items from
+/// a single producer must reach any one consumer in increasing order.
+fn consumerMain(state: *SharedState, consumer: usize) void {
+    state.waitForStart();
+    const producers = state.config.producers;
+    const last = state.last_orders[consumer * producers ..][0..producers];
+    while (state.consumed.load(.monotonic) < state.total()) {
+        if (state.failed.load(.monotonic)) return;
+        const removed = state.adt.remove() catch |err| {
+            if (err == errors.AdtError.Empty) {
+                std.Thread.yield() catch {};
+                continue;
+            }
+            state.failed.store(true, .monotonic);
+            return;
+        };
+        defer removed.deinit() catch {};
+        const value = removed.getValue() catch {
+            state.failed.store(true, .monotonic);
+            return;
+        };
+        const order = removed.getOrderId() catch {
+            state.failed.store(true, .monotonic);
+            return;
+        };
+        const producer: usize = if (value < 0) producers else @intCast(value);
+        if (producer >= producers or order <= last[producer]) {
+            _ = state.order_violations.fetchAdd(1, .monotonic);
+        } else {
+            last[producer] = order;
+        }
+        _ = state.consumed.fetchAdd(1, .monotonic);
+    }
+}
+
+/// Runs one producers x consumers stress case against a fresh ADT and
+/// records its throughput as a measurement of enqueue+dequeue pairs.
+pub fn runConcurrentCase(allocator: Allocator, builder: ADTSimpleBuilder, config: ConcurrentCaseConfig) !TestCaseResult {
+    var result = TestCaseResult.init(config.name, allocator);
+    errdefer result.deinit();
+
+    const adt_instance = builder.create() catch {
+        result.recordFailure("ADT creation failed", null, null, null);
+        return result;
+    };
+    defer adt_instance.deinit() catch {};
+
+    const last_orders = try allocator.alloc(i32, config.consumers * config.producers);
+    defer allocator.free(last_orders);
+    @memset(last_orders, -1);
+
+    var state = SharedState{ .adt = adt_instance, .config = config, .last_orders = last_orders };
+    var timer = try std.time.Timer.start();
+
+    const threads = try allocator.alloc(std.Thread, config.producers + config.consumers);
+    defer allocator.free(threads);
+    var spawned: usize = 0;
+    var spawn_failed = false;
+    for (0..config.producers) |p| {
+        threads[spawned] = std.Thread.spawn(.{}, producerMain, .{ &state, p }) catch {
+            spawn_failed = true;
+            break;
+        };
+        spawned += 1;
+    }
+    if (!spawn_failed) {
+        for (0..config.consumers) |i| {
+            threads[spawned] = std.Thread.spawn(.{}, consumerMain, .{ &state, i }) catch {
+                spawn_failed = true;
+                break;
+            };
+            spawned += 1;
+        }
+    }
+    if (spawn_failed) state.failed.store(true, .monotonic);
+
+    timer.reset();
+    state.start.store(true, .release);
+    for (threads[0..spawned]) |thread| thread.join();
+    const duration_ns = timer.read();
+
+    if (spawn_failed) {
+        result.recordFailure("Could not spawn worker threads", null, null, null);
+        return result;
+    }
+    if (state.failed.load(.monotonic)) {
+        result.recordFailure("ADT operation failed during concurrent run", null, null, null);
+        return result;
+    }
+    const violations = state.order_violations.load(.monotonic);
+    if (violations > 0) {
+        const details = try std.fmt.allocPrint(allocator, "{d} items arrived out of per-producer FIFO order", .{violations});
+        defer allocator.free(details);
+        result.recordFailure("FIFO order violated", details, null, null);
+        return result;
+    }
+    const leftover = adt_instance.remove();
+    if (leftover) |item| {
+        item.deinit() catch {};
+        result.recordFailure("ADT not empty after all items were consumed", null, null, null);
+        return result;
+    } else |_| {}
+
+    const total = state.total();
+    try result.addMeasurement(.{
+        .operation = "concurrent_insert_remove",
+        .input_size_n = @intCast(total),
+        .duration_ns = duration_ns,
+        .operations_count = 2 * total,
+    });
+
+    const seconds = @as(f64, @floatFromInt(@max(duration_ns, 1))) / std.time.ns_per_s;
+    const ops_per_second = @as(f64, @floatFromInt(2 * total)) / seconds;
+    const threads_used: f64 = @floatFromInt(config.producers + config.consumers);
+    try logging.log(.Info, "  {s}: {d} producers / {d} consumers, {d:.0} ops/s ({d:.0} ops/s per thread)\n", .{
+        config.name, config.producers, config.consumers, ops_per_second, ops_per_second / threads_used,
+    });
+    return result;
+}
+
+pub const PriorityCaseConfig = struct {
+    name: []const u8,
+    threads: usize = 1,
+    items_per_thread: usize = 100_000,
+    seed: u64 = 1,
+};
+
+/// State shared by the threads of one priority queue case.
+const PriorityState = struct {
+    adt: ADTSimple,
+    /// A permutation of 0..values.len-1; item i is inserted as
+    /// { .value = values[i], .order = i }.
+    values: []const i32,
+    threads: usize,
+    failed: std.atomic.Value(bool) = std.atomic.Value(bool).init(false),
+    stalled: std.atomic.Value(bool) = std.atomic.Value(bool).init(false),
+    /// Each successful remove takes the next ticket and stores its value
+    /// there, which orders the removes for the rank error replay.
+    next_ticket: std.atomic.Value(usize) = std.atomic.Value(usize).init(0),
+    removed: []i32,
+};
+
+fn priorityInserterMain(state: *PriorityState, thread: usize) void {
+    const total = state.values.len;
+    var index = thread * total / state.threads;
+    const end = (thread + 1) * total / state.threads;
+    while (index < end) {
+        if (state.failed.load(.monotonic)) return;
+        state.adt.insertValue(.{ .value = state.values[index], .order = @intCast(index) }) catch |err| {
+            if (err == errors.AdtError.Full) {
+                std.Thread.yield() catch {};
+                continue;
+            }
+            state.failed.store(true, .monotonic);
+            return;
+        };
+        index += 1;
+    }
+}
+
+/// Removes until every inserted item has a ticket. Every insert finished
+/// before the removers started, so a queue that keeps reporting empty
+/// before then has lost items.
+fn priorityRemoverMain(state: *PriorityState, thread: usize) void {
+    _ = thread;
+    const total = state.values.len;
+    const max_consecutive_empty = 100_000;
+    var consecutive_empty: usize = 0;
+    var slot: [1]c.CTrackedItem = undefined;
+    while (state.next_ticket.load(.monotonic) < total) {
+        if (state.failed.load(.monotonic)) return;
+        var done: usize = 0;
+        state.adt.removeInto(&slot, &done) catch |err| {
+            if (err == errors.AdtError.Empty) {
+                consecutive_empty += 1;
+                if (consecutive_empty > max_consecutive_empty) {
+                    state.stalled.store(true, .monotonic);
+                    state.failed.store(true, .monotonic);
+                    return;
+                }
+                std.Thread.yield() catch {};
+                continue;
+            }
+            state.failed.store(true, .monotonic);
+            return;
+        };
+        consecutive_empty = 0;
+        const ticket = state.next_ticket.fetchAdd(1, .monotonic);
+        if (ticket >= total) {
+            state.failed.store(true, .monotonic);
+            return;
+        }
+        state.removed[ticket] = slot[0].value;
+    }
+}
+
+/// Spawns `count` threads running func(state, index) and joins them.
+/// Returns the time from the first spawn to the last join, or null if a
+/// spawn failed.
+fn runThreads(allocator: Allocator, count: usize, comptime func: anytype, state: *PriorityState) !?u64 {
+    const threads = try allocator.alloc(std.Thread, count);
+    defer allocator.free(threads);
+    var spawned: usize = 0;
+    var spawn_failed = false;
+    var timer = try std.time.Timer.start();
+    for (0..count) |i| {
+        threads[spawned] = std.Thread.spawn(.{}, func, .{ state, i }) catch {
+            spawn_failed = true;
+            break;
+        };
+        spawned += 1;
+    }
+    for (threads[0..spawned]) |thread| thread.join();
+    const duration_ns = timer.read();
+    return if (spawn_failed) null else duration_ns;
+}
+
+/// Mean and maximum rank error of the removes in ticket order: how many
+/// smaller values were still in the queue when each value came out. A
+/// strict priority queue scores 0, up to the few removes whose tickets are
+/// taken out of order by racing threads.
+const RankError = struct { mean: f64, max: u64 };
+
+fn rankError(allocator: Allocator, removed: []const i32) !RankError {
+    // Fenwick tree over the values still present.
+    const tree = try allocator.alloc(u32, removed.len + 1);
+    defer allocator.free(tree);
+    @memset(tree, 0);
+    for (1..tree.len) |i| {
+        tree[i] += 1;
+        const parent = i + (i & (~i +% 1));
+        if (parent < tree.len) tree[parent] += tree[i];
+    }
+    var sum: u64 = 0;
+    var max: u64 = 0;
+    for (removed) |value| {
+        const position: usize = @intCast(value);
+        var smaller: u64 = 0;
+        var i = position;
+        while (i > 0) : (i &= i - 1) smaller += tree[i];
+        sum += smaller;
+        max = @max(max, smaller);
+        i = position + 1;
+        while (i < tree.len) : (i += i & (~i +% 1)) tree[i] -= 1;
+    }
+    const count: f64 = @floatFromInt(@max(removed.len, 1));
+    return .{ .mean = @as(f64, @floatFromInt(sum)) / count, .max = max };
+}
+
+/// Fills a priority queue from config.threads threads, then drains it from
+/// as many. Records the throughput of both phases and reports the rank
+/// error of the drain; fails only if items were lost, duplicated or left
+/// behind.
+pub fn runPriorityCase(allocator: Allocator, builder: ADTSimpleBuilder, config: PriorityCaseConfig) !TestCaseResult {
+    var result = TestCaseResult.init(config.name, allocator);
+    errdefer result.deinit();
+
+    const total = config.threads * config.items_per_thread;
+    if (total > std.math.maxInt(i32)) {
+        result.recordFailure("Too many items for i32 values", null, null, null);
+        return result;
+    }
+    const values = try allocator.alloc(i32, total);
+    defer allocator.free(values);
+    for (values, 0..) |*value, i| value.* = @intCast(i);
+    var prng = std.Random.DefaultPrng.init(config.seed);
+    prng.random().shuffle(i32, values);
+    const removed = try allocator.alloc(i32, total);
+    defer allocator.free(removed);
+
+    const adt_instance = builder.create() catch {
+        result.recordFailure("ADT creation failed", null, null, null);
+        return result;
+    };
+    defer adt_instance.deinit() catch {};
+
+    var state = PriorityState{ .adt = adt_instance, .values = values, .threads = config.threads, .removed = removed };
+    const insert_ns = try runThreads(allocator, config.threads, priorityInserterMain, &state);
+    const remove_ns = if (insert_ns != null and !state.failed.load(.monotonic))
+        try runThreads(allocator, config.threads, priorityRemoverMain, &state)
+    else
+        null;
+
+    if (insert_ns == null or (remove_ns == null and !state.failed.load(.monotonic))) {
+        result.recordFailure("Could not spawn worker threads", null, null, null);
+        return result;
+    }
+    if (state.stalled.load(.monotonic)) {
+        const details = try std.fmt.allocPrint(allocator, "{d} of {d} items came out before the queue stayed empty", .{ state.next_ticket.load(.monotonic), total });
+        defer allocator.free(details);
+        result.recordFailure("Items lost during concurrent run", details, null, null);
+        return result;
+    }
+    if (state.failed.load(.monotonic)) {
+        result.recordFailure("ADT operation failed during concurrent run", null, null, null);
+        return result;
+    }
+
+    const seen = try allocator.alloc(bool, total);
+    defer allocator.free(seen);
+    @memset(seen, false);
+    for (removed) |value| {
+        if (value < 0 or @as(usize, @intCast(value)) >= total or seen[@intCast(value)]) {
+            result.recordFailure("An item was removed twice or was never inserted", null, null, null);
+            return result;
+        }
+        seen[@intCast(value)] = true;
+    }
+    var leftover: [1]c.CTrackedItem = undefined;
+    var leftover_count: usize = 0;
+    if (adt_instance.removeInto(&leftover, &leftover_count)) {
+        result.recordFailure("ADT not empty after all items were consumed", null, null, null);
+        return result;
+    } else |_| {}
+
+    try result.addMeasurement(.{
+        .operation = "concurrent_insert",
+        .input_size_n = @intCast(total),
+        .duration_ns = insert_ns.?,
+        .operations_count = total,
+    });
+    try result.addMeasurement(.{
+        .operation = "concurrent_remove",
+        .input_size_n = @intCast(total),
+        .duration_ns = remove_ns.?,
+        .operations_count = total,
+    });
+
+    const rank_error = try rankError(allocator, removed);
+    const items: f64 = @floatFromInt(total);
+    const insert_rate = items * std.time.ns_per_s / @as(f64, @floatFromInt(@max(insert_ns.?, 1)));
+    const remove_rate = items * std.time.ns_per_s / @as(f64, @floatFromInt(@max(remove_ns.?, 1)));
+    try logging.log(.Info, "  {s}: {d} threads, insert {d:.0} ops/s, remove {d:.0} ops/s, rank error mean {d:.2} max {d}\n", .{
+        config.name, config.threads, insert_rate, remove_rate, rank_error.mean, rank_error.max,
+    });
+    const cpus = std.Thread.getCpuCount() catch 1;
+    if (config.threads > cpus) {
+        try logging.log(.Info, "  {s}: more threads than the {d} CPUs; preempted lock holders inflate the rank error\n", .{ config.name, cpus });
+    }
+    return result;
+}
@@ -3,6 +3,8 @@ const c = @cImport({
     @cInclude("testing");
 });
 const tracked_item = @import("tracked_item.zig");
+const perf_counters = @import("perf_counters.zig");
+const heap_stats = @import("heap_stats.zig");
 
 pub const insertionOrder = enum(c_int) { unknown = 0, firstInFirstOut = -1, firstInLastOut = -2, _ };
 
@@ -52,6 +54,15 @@ pub const AdtSimpleTestingOptions = struct {
     num_iterations: u32 = 1,
     timeout_ms: ?u64 = 5000,
     fail_fast: bool = false,
+    perf_counters: bool = false,
+    threads: u32 = 1,
+    benchmark: bool = false,
+    benchmark_warmup_iterations: u32 = 2,
+    benchmark_repetitions: u32 = 10,
+    benchmark_all_inputs: bool = false,
+    benchmark_pin_cpu: ?u32 = null,
+    benchmark_csv_path: ?[]const u8 = null,
+    benchmark_json_path: ?[]const u8 = null,
     pub fn convert(options: *c.adtSimpleTestingOptions) AdtSimpleTestingOptions {
         var input_sizes: ?[]c_int = null;
         if (options.input_sizes) |s| {
@@ -68,6 +79,18 @@ pub const AdtSimpleTestingOptions = struct {
             .expected_insert_complexity = @enumFromInt(options.expected_insert_complexity),
             .expected_peek_complexity = @enumFromInt(options.expected_peek_complexity),
             .expected_remove_complexity = @enumFromInt(options.expected_remove_complexity),
+            .num_iterations = @intCast(@max(options.num_iterations, 1)),
+            .perf_counters = options.perf_counters,
+            .threads = @intCast(@max(options.test_threads, 0)),
+            .prng_seed = options.seed,
+            .max_operations_for_timing = @intCast(@max(options.max_operations_for_timing, 1)),
+            .benchmark = options.benchmark,
+            .benchmark_warmup_iterations = @intCast(@max(options.benchmark_warmup_iterations, 0)),
+            .benchmark_repetitions = @intCast(@max(options.benchmark_repetitions, 1)),
+            .benchmark_all_inputs = options.benchmark_all_inputs,
+            .benchmark_pin_cpu = if (options.benchmark_pin_cpu >= 0) @intCast(options.benchmark_pin_cpu) else null,
+            .benchmark_csv_path = if (options.benchmark_csv_path) |p| std.mem.span(p) else null,
+            .benchmark_json_path = if (options.benchmark_json_path) |p| std.mem.span(p) else null,
         };
     }
 };
@@ -77,6 +100,16 @@ pub const TestMeasurement = struct {
     input_size_n: u32,
     duration_ns: u64,
     operations_count: u64,
+    /// Allocator requests and heap calls made during the timed phase, when
+    /// the ADT reports them.
+    allocations: ?u64 = null,
+    heap_allocations: ?u64 = null,
+    /// Hardware counters over the timed phase, when they were requested
+    /// and the machine provides them.
+    counters: ?perf_counters.PerfCounts = null,
+    /// Global operator new/delete traffic during the timed phase, when the
+    /// binary was built with TESTING_TRACK_HEAP.
+    heap: ?heap_stats.HeapDelta = null,
 };
 
 pub const TestFailure = struct {
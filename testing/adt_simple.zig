@@ -23,6 +23,13 @@ pub const ADTSimple = struct {
         return errors.asTestingError(result_code);
     }
 
+    /// Inserts a plain C value, without a TrackingObject handle to own it.
+    pub fn insertValue(self: @This(), value: c.CTrackedItem) !void {
+        if (self.ops.insert == null) return errors.FrameworkError.TestLogicError;
+        const result_code = self.ops.insert.?(self.int_adt, value);
+        return errors.asTestingError(result_code);
+    }
+
     pub fn peek(self: @This()) !TrackingObject {
         if (self.ops.peek == null) return errors.FrameworkError.TestLogicError;
         var item_handle: c.TrackedItemHandle = null;
@@ -38,6 +45,45 @@ pub const ADTSimple = struct {
 
         return errors.unwrapTesting(TrackingObject, .{ .backing = item_handle }, result_code);
     }
+
+    /// Inserts every value in order, in one call through insert_batch when
+    /// the ADT provides it. On failure, done holds the number inserted.
+    pub fn insertAll(self: @This(), values: []const c.CTrackedItem, done: *usize) !void {
+        done.* = 0;
+        if (self.ops.insert_batch) |insert_batch| {
+            const result_code = insert_batch(self.int_adt, values.ptr, values.len, done);
+            return errors.asTestingError(result_code);
+        }
+        for (values) |value| {
+            try self.insertValue(value);
+            done.* += 1;
+        }
+    }
+
+    /// Removes out.len items into out, in one call through remove_batch
+    /// when the ADT provides it. On failure, done holds the number removed.
+    pub fn removeInto(self: @This(), out: []c.CTrackedItem, done: *usize) !void {
+        done.* = 0;
+        if (self.ops.remove_batch) |remove_batch| {
+            const result_code = remove_batch(self.int_adt, out.ptr, out.len, done);
+            return errors.asTestingError(result_code);
+        }
+        for (out) |*slot| {
+            const removed = try self.remove();
+            defer removed.deinit() catch {};
+            const value: *c.CTrackedItem = @ptrCast(removed.backing);
+            slot.* = value.*;
+            done.* += 1;
+        }
+    }
+
+    /// Cumulative allocator counters, or null if the ADT does not report them.
+    pub fn allocatorStats(self: @This()) ?c.AllocatorStats {
+        const stats_fn = self.ops.allocator_stats orelse return null;
+        var stats = std.mem.zeroes(c.AllocatorStats);
+        if (stats_fn(self.int_adt, &stats) != c.ADT_RESULT_SUCCESS) return null;
+        return stats;
+    }
 };
 
 pub const ADTSimpleBuilder = struct {
@@ -11,6 +11,8 @@ const input_generators = @import("input_generators.zig");
 const test_results = @import("test_results.zig");
 const test_runner = @import("test_runner.zig");
 const adt = @import("adt_simple.zig");
+const perf_counters = @import("perf_counters.zig");
+const heap_stats = @import("heap_stats.zig");
 const Verbosity = @import("adt_options.zig").Verbosity;
 const AdtSimpleTestingOptions = testing_types.AdtSimpleTestingOptions;
 const InsertionOrder = testing_types.InsertionOrder;
@@ -19,11 +21,49 @@ const ADTSimple = adt.ADTSimple;
 const ADTSimpleBuilder = adt.ADTSimpleBuilder;
 const Allocator = std.mem.Allocator;
 
+/// Allocator counters accumulated between two allocatorStats() snapshots.
+const AllocatorDelta = struct {
+    allocations: ?u64 = null,
+    heap_allocations: ?u64 = null,
+
+    fn between(before: ?c.AllocatorStats, after: ?c.AllocatorStats) AllocatorDelta {
+        const b = before orelse return .{};
+        const a = after orelse return .{};
+        return .{
+            .allocations = a.allocations - b.allocations,
+            .heap_allocations = a.heap_allocations - b.heap_allocations,
+        };
+    }
+};
+
 fn formatTracked(obj: TrackingObject, allocator: Allocator) ![]const u8 {
     const val = obj.getValue() catch -999;
     const id = obj.getOrderId() catch -999;
     return std.fmt.allocPrint(allocator, "Tracked(val={d}, id={d}, handle={?*})", .{ val, id, obj.backing });
 }
+var warned_counters_unavailable = false;
+
+/// Opens the counter group when the options ask for it. Machines without
+/// counters get a single warning and fall back to timing alone.
+fn openCounters(options: test_runner.TestOptions) !?perf_counters.PerfGroup {
+    if (!options.perf_counters) return null;
+    return perf_counters.PerfGroup.open() catch |err| {
+        if (!warned_counters_unavailable) {
+            warned_counters_unavailable = true;
+            try logging.log(.Warning, "Hardware counters unavailable ({s}), measuring time only\n", .{@errorName(err)});
+        }
+        return null;
+    };
+}
+
+fn startCounters(group: ?perf_counters.PerfGroup) void {
+    if (group) |g| g.start();
+}
+
+fn stopCounters(group: ?perf_counters.PerfGroup) ?perf_counters.PerfCounts {
+    return if (group) |g| g.stop() else null;
+}
+
 const MaybeTrackingObject = union { t: TrackingObject, v: void };
 pub fn runAdtTestCase(
     allocator: Allocator,
@@ -32,11 +72,12 @@ pub fn runAdtTestCase(
     prng: *std.Random,
 ) !TestCaseResult {
     var result = TestCaseResult.init(options.name, allocator);
-    const input_data_generated = input_generators.generateInputData(
+    var input = input_generators.generateInputData(
         allocator,
         options.input_type,
         options.input_sizes[0],
         prng,
+        .{},
     ) catch |err| {
         var err_msg_buf: [128]u8 = undefined;
         var err_fbs = std.io.fixedBufferStream(&err_msg_buf);
@@ -44,7 +85,9 @@ pub fn runAdtTestCase(
         result.recordFailure("Input data generation failed", err_fbs.getWritten(), null, null);
         return result;
     };
-    defer input_generators.deinitTrackingObjectSlice(allocator, input_data_generated);
+    defer input.deinit();
+    const input_data_generated = try input.trackingObjects(allocator);
+    defer allocator.free(input_data_generated);
 
     try logging.log(.Debug, "  Test: {s}, Input Size: {d}, Type: {s}\n", .{
         options.name, input_data_generated.len, @tagName(options.input_type),
@@ -82,37 +125,58 @@ pub fn runAdtTestCase(
         }
     };
 
+    var counter_group = try openCounters(options);
+    defer if (counter_group) |*group| group.close();
+    const record_measurements = options.estimate_complexity or counter_group != null;
+
+    // The timed phases read the input arena and write into a buffer for
+    // the removed items, so they only cross into the ADT and never
+    // allocate here.
+    const input_values = input.items;
+    const removed_values = try allocator.alloc(c.CTrackedItem, input_data_generated.len);
+    defer allocator.free(removed_values);
+
+    const stats_before_insert = adt_instance.allocatorStats();
+    const insert_heap_phase = heap_stats.HeapPhase.begin();
+    startCounters(counter_group);
     var timer = try std.time.Timer.start();
-    for (input_data_generated) |item_to_insert| {
-        adt_instance.insert(item_to_insert) catch |err| {
-            const item_str = formatTracked(item_to_insert, allocator) catch "FormattedItemError";
-            defer if (std.mem.eql(u8, item_str, "FormattedItemError")) {} else {
-                allocator.free(item_str);
-            };
-            var err_msg_buf: [128]u8 = undefined;
-            var err_fbs = std.io.fixedBufferStream(&err_msg_buf);
-            errors.formatError(err, err_fbs.writer()) catch {};
-            result.recordFailure(
-                "ADT insert failed",
-                try std.fmt.allocPrint(allocator, "Item: {s}, Error: {s}", .{ item_str, err_fbs.getWritten() }),
-                null,
-                null,
-            );
-            return result;
-        };
-    }
+    var inserted: usize = 0;
+    const insert_outcome = adt_instance.insertAll(input_values, &inserted);
     const insert_duration_ns = timer.read();
-    if (options.estimate_complexity) {
+    const insert_counters = stopCounters(counter_group);
+    const insert_heap = heap_stats.endPhase(insert_heap_phase);
+    insert_outcome catch |err| {
+        const item_to_insert = input_data_generated[@min(inserted, input_data_generated.len - 1)];
+        const item_str = formatTracked(item_to_insert, allocator) catch "FormattedItemError";
+        defer if (std.mem.eql(u8, item_str, "FormattedItemError")) {} else {
+            allocator.free(item_str);
+        };
+        var err_msg_buf: [128]u8 = undefined;
+        var err_fbs = std.io.fixedBufferStream(&err_msg_buf);
+        errors.formatError(err, err_fbs.writer()) catch {};
+        result.recordFailure(
+            "ADT insert failed",
+            try std.fmt.allocPrint(allocator, "Item: {s}, Error: {s}", .{ item_str, err_fbs.getWritten() }),
+            null,
+            null,
+        );
+        return result;
+    };
+    const insert_allocs = AllocatorDelta.between(stats_before_insert, adt_instance.allocatorStats());
+    if (record_measurements) {
         try result.addMeasurement(.{
             .operation = "insert_all",
             .input_size_n = @intCast(input_data_generated.len),
             .duration_ns = insert_duration_ns,
             .operations_count = @intCast(input_data_generated.len),
+            .allocations = insert_allocs.allocations,
+            .heap_allocations = insert_allocs.heap_allocations,
+            .counters = insert_counters,
+            .heap = insert_heap,
         });
     }
 
     if (input_data_generated.len > 0) {
-        timer.reset();
         const peeked_obj_wrapper = adt_instance.peek() catch |err| {
             var err_msg_buf: [128]u8 = undefined;
             var err_fbs = std.io.fixedBufferStream(&err_msg_buf);
@@ -121,9 +185,23 @@ pub fn runAdtTestCase(
             return result;
         };
 
-        const peek_duration_ns = timer.read();
-        if (options.estimate_complexity) {
-            try result.addMeasurement(.{ .operation = "peek_one", .input_size_n = @intCast(input_data_generated.len), .duration_ns = peek_duration_ns, .operations_count = 1 });
+        // A single peek is below timer resolution, so time a batch of them.
+        if (record_measurements) {
+            const peek_repeats = @max(options.max_operations_for_timing, 1);
+            const peek_heap_phase = heap_stats.HeapPhase.begin();
+            startCounters(counter_group);
+            timer.reset();
+            for (0..peek_repeats) |_| _ = try adt_instance.peek();
+            const peek_duration_ns = timer.read();
+            const peek_counters = stopCounters(counter_group);
+            try result.addMeasurement(.{
+                .operation = "peek_repeat",
+                .input_size_n = @intCast(input_data_generated.len),
+                .duration_ns = peek_duration_ns,
+                .operations_count = peek_repeats,
+                .counters = peek_counters,
+                .heap = heap_stats.endPhase(peek_heap_phase),
+            });
         }
 
         var expected_peek_candidate_idx: ?usize = null;
@@ -184,36 +262,43 @@ pub fn runAdtTestCase(
         }
     }
 
+    // Views into removed_values, which owns the removed items.
     var removed_items_list = std.ArrayList(TrackingObject).init(allocator);
-    defer {
-        for (removed_items_list.items) |item| item.deinit() catch {};
-        removed_items_list.deinit();
-    }
+    defer removed_items_list.deinit();
 
+    const stats_before_remove = adt_instance.allocatorStats();
+    const remove_heap_phase = heap_stats.HeapPhase.begin();
+    startCounters(counter_group);
     timer.reset();
-    var k: usize = 0;
-    while (k < input_data_generated.len) : (k += 1) {
-        const removed_obj = adt_instance.remove() catch |err| {
-            var err_msg_buf: [128]u8 = undefined;
-            var err_fbs = std.io.fixedBufferStream(&err_msg_buf);
-            errors.formatError(err, err_fbs.writer()) catch {};
-            result.recordFailure(
-                "ADT remove failed",
-                try std.fmt.allocPrint(allocator, "Attempted to remove item #{d} of {d}. Error: {s}", .{ k + 1, input_data_generated.len, err_fbs.getWritten() }),
-                null,
-                null,
-            );
-            return result;
-        };
-        try removed_items_list.append(removed_obj);
-    }
+    var removed_count: usize = 0;
+    const remove_outcome = adt_instance.removeInto(removed_values, &removed_count);
     const remove_duration_ns = timer.read();
-    if (options.estimate_complexity) {
+    const remove_counters = stopCounters(counter_group);
+    const remove_heap = heap_stats.endPhase(remove_heap_phase);
+    remove_outcome catch |err| {
+        var err_msg_buf: [128]u8 = undefined;
+        var err_fbs = std.io.fixedBufferStream(&err_msg_buf);
+        errors.formatError(err, err_fbs.writer()) catch {};
+        result.recordFailure(
+            "ADT remove failed",
+            try std.fmt.allocPrint(allocator, "Attempted to remove item #{d} of {d}. Error: {s}", .{ removed_count + 1, input_data_generated.len, err_fbs.getWritten() }),
+            null,
+            null,
+        );
+        return result;
+    };
+    for (removed_values) |*value| try removed_items_list.append(.{ .backing = @ptrCast(value) });
+    const remove_allocs = AllocatorDelta.between(stats_before_remove, adt_instance.allocatorStats());
+    if (record_measurements) {
         try result.addMeasurement(.{
             .operation = "remove_all",
             .input_size_n = @intCast(input_data_generated.len),
             .duration_ns = remove_duration_ns,
             .operations_count = @intCast(input_data_generated.len),
+            .allocations = remove_allocs.allocations,
+            .heap_allocations = remove_allocs.heap_allocations,
+            .counters = remove_counters,
+            .heap = remove_heap,
         });
     }
 
@@ -0,0 +1,250 @@
+const std = @import("std");
+const builtin = @import("builtin");
+const c = @cImport({
+    @cInclude("testing");
+});
+const logging = @import("logging.zig");
+const errors = @import("error.zig");
+const adt = @import("adt_simple.zig");
+const input_generators = @import("input_generators.zig");
+
+const ADTSimpleBuilder = adt.ADTSimpleBuilder;
+const TestInputType = input_generators.TestInputType;
+const Allocator = std.mem.Allocator;
+
+pub const BenchmarkOptions = struct {
+    adt_name: []const u8,
+    input_types: []const TestInputType = &.{.RandomUniqueValues},
+    input_sizes: []const c_int,
+    warmup_iterations: u32 = 2,
+    repetitions: u32 = 10,
+    /// Operations per timed region. The structure is first filled to
+    /// n - k untimed, so the k timed operations run at size ~n.
+    max_operations_for_timing: u32 = 10000,
+    /// The timed region is timed in sub-batches of this many operations,
+    /// and every sub-batch is one latency sample. Percentiles are taken
+    /// over the samples of all repetitions, so they show the spread within
+    /// a repetition too. Each sample carries one timer read (~20ns) spread
+    /// over the batch.
+    operations_per_sample: u32 = 64,
+    pin_cpu: ?u32 = null,
+    csv_path: ?[]const u8 = null,
+    json_path: ?[]const u8 = null,
+    seed: u64 = 1,
+};
+
+/// One row of output: per-operation latency over the sub-batch samples of
+/// all repetitions.
+pub const BenchmarkRecord = struct {
+    adt: []const u8,
+    operation: []const u8,
+    input_type: []const u8,
+    n: u32,
+    repetitions: u32,
+    operations_per_repetition: u32,
+    operations_per_sample: u32,
+    samples: u32,
+    min_ns: f64,
+    median_ns: f64,
+    p99_ns: f64,
+    ops_per_sec: f64,
+};
+
+const Operation = enum { insert, peek, remove };
+
+/// Pins the calling thread to one CPU through the raw sched_setaffinity
+/// syscall, so it works without libc.
+pub fn pinToCpu(cpu: u32) !void {
+    if (builtin.os.tag != .linux) return error.Unsupported;
+    const word_bits = @bitSizeOf(usize);
+    var set = [_]usize{0} ** (1024 / word_bits);
+    if (cpu >= set.len * word_bits) return error.InvalidCpu;
+    set[cpu / word_bits] |= @as(usize, 1) << @intCast(cpu % word_bits);
+    const rc = std.os.linux.syscall3(.sched_setaffinity, 0, @sizeOf(@TypeOf(set)), @intFromPtr(&set));
+    if (std.os.linux.E.init(rc) != .SUCCESS) return error.AffinityFailed;
+}
+
+fn nanosPerOp(duration_ns: u64, operations: usize) f64 {
+    return @as(f64, @floatFromInt(duration_ns)) / @as(f64, @floatFromInt(@max(operations, 1)));
+}
+
+fn batchCount(timed: usize, batch: usize) usize {
+    return (timed + batch - 1) / batch;
+}
+
+/// Runs one repetition, timing the timed operations in sub-batches of
+/// batch. If samples is non-null, samples[@intFromEnum(op)][i] receives the
+/// per-op latency of sub-batch i. Inserts and removes go through the batch
+/// entry points when the ADT has them, into buffers allocated up front.
+fn runRepetition(builder: ADTSimpleBuilder, values: []const c.CTrackedItem, removed: []c.CTrackedItem, timed: usize, batch: usize, samples: ?[3][]f64) !void {
+    const instance = try builder.create();
+    defer instance.deinit() catch {};
+
+    const untimed = values.len - timed;
+    var done: usize = 0;
+    try instance.insertAll(values[0..untimed], &done);
+
+    const batches = batchCount(timed, batch);
+    var timer = try std.time.Timer.start();
+    for (0..batches) |i| {
+        const start = i * batch;
+        const end = @min(start + batch, timed);
+        timer.reset();
+        try instance.insertAll(values[untimed + start .. untimed + end], &done);
+        const ns = timer.read();
+        if (samples) |s| s[@intFromEnum(Operation.insert)][i] = nanosPerOp(ns, end - start);
+    }
+
+    for (0..batches) |i| {
+        const start = i * batch;
+        const end = @min(start + batch, timed);
+        timer.reset();
+        for (start..end) |_| _ = try instance.peek();
+        const ns = timer.read();
+        if (samples) |s| s[@intFromEnum(Operation.peek)][i] = nanosPerOp(ns, end - start);
+    }
+
+    for (0..batches) |i| {
+        const start = i * batch;
+        const end = @min(start + batch, timed);
+        timer.reset();
+        try instance.removeInto(removed[start..end], &done);
+        const ns = timer.read();
+        if (samples) |s| s[@intFromEnum(Operation.remove)][i] = nanosPerOp(ns, end - start);
+    }
+
+    try instance.removeInto(removed[timed..], &done);
+}
+
+/// Nearest-rank percentile of sorted samples.
+fn percentile(sorted: []const f64, p: f64) f64 {
+    const rank = @ceil(p / 100.0 * @as(f64, @floatFromInt(sorted.len)));
+    const index: usize = @intFromFloat(@max(rank, 1) - 1);
+    return sorted[@min(index, sorted.len - 1)];
+}
+
+fn summarize(options: BenchmarkOptions, op: Operation, input_type: TestInputType, n: usize, timed: usize, batch: usize, repetitions: u32, samples: []f64) BenchmarkRecord {
+    std.mem.sort(f64, samples, {}, std.sort.asc(f64));
+    const median = percentile(samples, 50);
+    return .{
+        .adt = options.adt_name,
+        .operation = @tagName(op),
+        .input_type = @tagName(input_type),
+        .n = @intCast(n),
+        .repetitions = repetitions,
+        .operations_per_repetition = @intCast(timed),
+        .operations_per_sample = @intCast(batch),
+        .samples = @intCast(samples.len),
+        .min_ns = samples[0],
+        .median_ns = median,
+        .p99_ns = percentile(samples, 99),
+        .ops_per_sec = if (median > 0) std.time.ns_per_s / median else 0,
+    };
+}
+
+/// Benchmarks every input type and size in options. The caller owns the
+/// returned records.
+pub fn run(allocator: Allocator, builder: ADTSimpleBuilder, options: BenchmarkOptions) ![]BenchmarkRecord {
+    if (options.pin_cpu) |cpu| {
+        pinToCpu(cpu) catch |err| {
+            try logging.log(.Warning, "Could not pin benchmark to CPU {d}: {any}\n", .{ cpu, err });
+        };
+    }
+    const repetitions = @max(options.repetitions, 1);
+
+    var records = std.ArrayList(BenchmarkRecord).init(allocator);
+    errdefer records.deinit();
+
+    var prng_state = std.Random.DefaultPrng.init(options.seed);
+    var prng = prng_state.random();
+
+    for (options.input_types) |input_type| {
+        for (options.input_sizes) |size| {
+            if (size <= 0) continue;
+            var input = try input_generators.generateInputData(allocator, input_type, size, &prng, .{});
+            defer input.deinit();
+            const values = input.items;
+            const timed = @min(values.len, @as(usize, @max(options.max_operations_for_timing, 1)));
+            const batch = @min(timed, @as(usize, @max(options.operations_per_sample, 1)));
+            const batches = batchCount(timed, batch);
+            const removed = try allocator.alloc(c.CTrackedItem, values.len);
+            defer allocator.free(removed);
+            // One column of samples per operation, repetition after repetition.
+            const columns = try allocator.alloc(f64, 3 * repetitions * batches);
+            defer allocator.free(columns);
+            const per_op = repetitions * batches;
+
+            for (0..options.warmup_iterations) |_| try runRepetition(builder, values, removed, timed, batch, null);
+            for (0..repetitions) |r| {
+                var samples: [3][]f64 = undefined;
+                for (&samples, 0..) |*column, op| {
+                    const first = op * per_op + r * batches;
+                    column.* = columns[first .. first + batches];
+                }
+                try runRepetition(builder, values, removed, timed, batch, samples);
+            }
+
+            inline for (std.meta.fields(Operation)) |field| {
+                const op: Operation = @enumFromInt(field.value);
+                const column = columns[field.value * per_op .. (field.value + 1) * per_op];
+                const record = summarize(options, op, input_type, values.len, timed, batch, repetitions, column);
+                try records.append(record);
+                try logging.log(.Info, "  {s} {s} {s} N={d}: min {d:.1}ns, median {d:.1}ns, p99 {d:.1}ns over {d} samples of {d} ops, {d:.0} ops/s\n", .{
+                    record.adt, record.operation, record.input_type, record.n, record.min_ns, record.median_ns, record.p99_ns, record.samples, record.operations_per_sample, record.ops_per_sec,
+                });
+            }
+        }
+    }
+
+    const result = try records.toOwnedSlice();
+    errdefer allocator.free(result);
+    if (options.csv_path) |path| try writeCsvFile(path, result);
+    if (options.json_path) |path| try writeJsonFile(path, result);
+    return result;
+}
+
+pub const csv_header = "adt,operation,input_type,n,repetitions,operations_per_repetition,operations_per_sample,samples,min_ns,median_ns,p99_ns,ops_per_sec\n";
+
+pub fn writeCsv(writer: anytype, records: []const BenchmarkRecord) !void {
+    for (records) |r| {
+        try writer.print("{s},{s},{s},{d},{d},{d},{d},{d},{d:.3},{d:.3},{d:.3},{d:.1}\n", .{
+            r.adt, r.operation, r.input_type, r.n, r.repetitions, r.operations_per_repetition, r.operations_per_sample, r.samples, r.min_ns, r.median_ns, r.p99_ns, r.ops_per_sec,
+        });
+    }
+}
+
+/// JSON Lines: one object per record, so runs of several ADTs can append
+/// to the same file.
+pub fn writeJson(writer: anytype, records: []const BenchmarkRecord) !void {
+    for (records) |r| {
+        try std.json.stringify(r, .{}, writer);
+        try writer.writeByte('\n');
+    }
+}
+
+/// Opens path for appending, creating it if needed. Returns whether the
+/// file was empty.
+fn openForAppend(path: []const u8) !struct { file: std.fs.File, was_empty: bool } {
+    const file = try std.fs.cwd().createFile(path, .{ .truncate = false });
+    errdefer file.close();
+    const end = try file.getEndPos();
+    try file.seekTo(end);
+    return .{ .file = file, .was_empty = end == 0 };
+}
+
+fn writeCsvFile(path: []const u8, records: []const BenchmarkRecord) !void {
+    const out = try openForAppend(path);
+    defer out.file.close();
+    var buffered = std.io.bufferedWriter(out.file.writer());
+    if (out.was_empty) try buffered.writer().writeAll(csv_header);
+    try writeCsv(buffered.writer(), records);
+    try buffered.flush();
+}
+
+fn writeJsonFile(path: []const u8, records: []const BenchmarkRecord) !void {
+    const out = try openForAppend(path);
+    defer out.file.close();
+    var buffered = std.io.bufferedWriter(out.file.writer());
+    try writeJson(buffered.writer(), records);
+    try buffered.flush();
+}
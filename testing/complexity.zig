@@ -0,0 +1,120 @@
+const std = @import("std");
+const testing_types = @import("adt_options.zig");
+const Complexity = testing_types.Complexity;
+const TestMeasurement = testing_types.TestMeasurement;
+const Allocator = std.mem.Allocator;
+
+/// Growth classes the estimator chooses between, from slowest to fastest.
+pub const candidates = [_]Complexity{ .@"O(1)", .@"O(logN)", .@"O(N)", .@"O(NlogN)", .@"O(N^2)" };
+
+/// Fewer distinct input sizes than this cannot tell the candidates apart.
+pub const min_distinct_sizes = 4;
+
+/// Below this confidence a best fit is reported but not trusted enough to
+/// fail a test on.
+pub const default_min_confidence = 0.25;
+
+pub const Sample = struct {
+    n: f64,
+    ns_per_op: f64,
+};
+
+pub const Fit = struct {
+    complexity: Complexity,
+    /// ns per operation per unit of growth, t(n) ~= coefficient * g(n).
+    coefficient: f64 = 0,
+    /// Root mean square residual, relative to the mean time per operation.
+    rms: f64 = 0,
+    /// How much better the best candidate fits than the runner-up, from 0
+    /// (indistinguishable) to 1 (the runner-up explains nothing).
+    confidence: f64 = 0,
+};
+
+pub fn isCandidate(complexity: Complexity) bool {
+    return std.mem.indexOfScalar(Complexity, &candidates, complexity) != null;
+}
+
+fn growth(complexity: Complexity, n: f64) f64 {
+    const log_n = std.math.log2(@max(n, 2));
+    return switch (complexity) {
+        .@"O(1)" => 1,
+        .@"O(logN)" => log_n,
+        .@"O(N)" => n,
+        .@"O(NlogN)" => n * log_n,
+        .@"O(N^2)" => n * n,
+        else => unreachable,
+    };
+}
+
+/// Least-squares fit of t(n) = coefficient * g(n) through the origin.
+fn fitCandidate(samples: []const Sample, complexity: Complexity) Fit {
+    var sum_tg: f64 = 0;
+    var sum_gg: f64 = 0;
+    var sum_t: f64 = 0;
+    for (samples) |s| {
+        const g = growth(complexity, s.n);
+        sum_tg += s.ns_per_op * g;
+        sum_gg += g * g;
+        sum_t += s.ns_per_op;
+    }
+    const coefficient = if (sum_gg > 0) sum_tg / sum_gg else 0;
+    var sum_squared_residuals: f64 = 0;
+    for (samples) |s| {
+        const residual = s.ns_per_op - coefficient * growth(complexity, s.n);
+        sum_squared_residuals += residual * residual;
+    }
+    const count: f64 = @floatFromInt(samples.len);
+    const mean = sum_t / count;
+    const rms = @sqrt(sum_squared_residuals / count);
+    return .{
+        .complexity = complexity,
+        .coefficient = coefficient,
+        .rms = if (mean > 0) rms / mean else 0,
+    };
+}
+
+/// Fits every candidate and returns the one with the smallest residual.
+/// Returns .InsufficientData when samples cover too few distinct sizes.
+pub fn bestFit(samples: []const Sample) Fit {
+    if (samples.len < min_distinct_sizes) return .{ .complexity = .InsufficientData };
+
+    var best = fitCandidate(samples, candidates[0]);
+    var runner_up_rms = std.math.inf(f64);
+    for (candidates[1..]) |candidate| {
+        const fit = fitCandidate(samples, candidate);
+        if (fit.rms < best.rms) {
+            runner_up_rms = best.rms;
+            best = fit;
+        } else if (fit.rms < runner_up_rms) {
+            runner_up_rms = fit.rms;
+        }
+    }
+    best.confidence = if (runner_up_rms > 0) 1 - best.rms / runner_up_rms else 0;
+    return best;
+}
+
+/// Turns the measurements of one operation into one sample per input
+/// size, sorted by size. Repeated sizes keep their fastest run, which is
+/// the one least disturbed by noise. The caller owns the returned slice.
+pub fn collectSamples(allocator: Allocator, measurements: []const TestMeasurement, operation: []const u8) ![]Sample {
+    var samples = std.ArrayList(Sample).init(allocator);
+    errdefer samples.deinit();
+    for (measurements) |m| {
+        if (!std.mem.eql(u8, m.operation, operation)) continue;
+        if (m.input_size_n == 0 or m.operations_count == 0) continue;
+        const n: f64 = @floatFromInt(m.input_size_n);
+        const ns_per_op = @as(f64, @floatFromInt(m.duration_ns)) / @as(f64, @floatFromInt(m.operations_count));
+        for (samples.items) |*existing| {
+            if (existing.n == n) {
+                existing.ns_per_op = @min(existing.ns_per_op, ns_per_op);
+                break;
+            }
+        } else try samples.append(.{ .n = n, .ns_per_op = ns_per_op });
+    }
+    std.mem.sort(Sample, samples.items, {}, struct {
+        fn lessThan(_: void, a: Sample, b: Sample) bool {
+            return a.n < b.n;
+        }
+    }.lessThan);
+    return samples.toOwnedSlice();
+}
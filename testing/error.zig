@@ -9,6 +9,7 @@ pub const AdtError = error{
     Empty,
     Alloc,
     InvalidHandle,
+    Full,
     Other,
 };
 
@@ -33,6 +34,7 @@ pub inline fn fromCErrorCode(code: c_int) AdtError {
         c.ADT_RESULT_ERROR_EMPTY => AdtError.Empty,
         c.ADT_RESULT_ERROR_ALLOC => AdtError.Alloc,
         c.ADT_RESULT_ERROR_INVALID_HANDLE => AdtError.InvalidHandle,
+        c.ADT_RESULT_ERROR_FULL => AdtError.Full,
         else => AdtError.Other,
     };
 }
@@ -50,6 +52,7 @@ pub inline fn testingErrorToCInt(err: TestingError) c_int {
         AdtError.Empty => c.ADT_RESULT_ERROR_EMPTY,
         AdtError.Alloc => c.ADT_RESULT_ERROR_ALLOC,
         AdtError.InvalidHandle => c.ADT_RESULT_ERROR_INVALID_HANDLE,
+        AdtError.Full => c.ADT_RESULT_ERROR_FULL,
         AdtError.Other => c.ADT_RESULT_ERROR_OTHER,
         else=>c.ADT_RESULT_ERROR_OTHER,
     };
@@ -61,6 +64,7 @@ pub fn formatError(err: anyerror, writer: anytype) !void {
         AdtError.Empty => try writer.writeAll("AdtError.Empty"),
         AdtError.Alloc => try writer.writeAll("AdtError.Alloc"),
         AdtError.InvalidHandle => try writer.writeAll("AdtError.InvalidHandle"),
+        AdtError.Full => try writer.writeAll("AdtError.Full"),
         AdtError.Other => try writer.writeAll("AdtError.Other"),
         FrameworkError.VerificationFailed => try writer.writeAll("FrameworkError.VerificationFailed"),
         FrameworkError.Timeout => try writer.writeAll("FrameworkError.Timeout"),
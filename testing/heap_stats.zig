@@ -0,0 +1,71 @@
+const std = @import("std");
+
+/// Laid out like the C HeapStats in testing.h, which the replaced global
+/// operator new/delete of a TESTING_TRACK_HEAP binary keep up to date.
+pub const HeapStats = extern struct {
+    allocations: u64 = 0,
+    frees: u64 = 0,
+    bytes_allocated: u64 = 0,
+    bytes_freed: u64 = 0,
+    live_bytes: u64 = 0,
+    peak_live_bytes: u64 = 0,
+};
+
+/// Heap traffic of one measured phase. peak_live_bytes is the most the
+/// phase held on top of what was live when it started.
+pub const HeapDelta = struct {
+    allocations: u64,
+    frees: u64,
+    bytes_allocated: u64,
+    bytes_freed: u64,
+    peak_live_bytes: u64,
+};
+
+// Null unless the C++ binary replaced operator new/delete.
+var counters: ?*HeapStats = null;
+
+export fn register_heap_counters(stats: *HeapStats) void {
+    @atomicStore(?*HeapStats, &counters, stats, .release);
+}
+
+fn load(stats: *const HeapStats) HeapStats {
+    var result = HeapStats{};
+    inline for (std.meta.fields(HeapStats)) |field| {
+        @field(result, field.name) = @atomicLoad(u64, &@field(stats.*, field.name), .monotonic);
+    }
+    return result;
+}
+
+/// A snapshot taken at the start of a phase. Phases must not overlap, and
+/// heap traffic from other threads during a phase is counted with it.
+pub const HeapPhase = struct {
+    block: *HeapStats,
+    start: HeapStats,
+
+    /// Starts a phase, or returns null when heap accounting is off.
+    pub fn begin() ?HeapPhase {
+        const block = @atomicLoad(?*HeapStats, &counters, .acquire) orelse return null;
+        // Restart the high-water mark from what is live now, so the peak
+        // after the phase is the phase's own.
+        const live = @atomicLoad(u64, &block.live_bytes, .monotonic);
+        @atomicStore(u64, &block.peak_live_bytes, live, .monotonic);
+        return .{ .block = block, .start = load(block) };
+    }
+
+    pub fn end(self: HeapPhase) HeapDelta {
+        const now = load(self.block);
+        return .{
+            .allocations = now.allocations - self.start.allocations,
+            .frees = now.frees - self.start.frees,
+            .bytes_allocated = now.bytes_allocated - self.start.bytes_allocated,
+            .bytes_freed = now.bytes_freed - self.start.bytes_freed,
+            .peak_live_bytes = now.peak_live_bytes -| self.start.live_bytes,
+        };
+    }
+};
+
+/// Closes a phase started with HeapPhase.begin(), if there was one.
+pub fn endPhase(phase: ?HeapPhase) ?HeapDelta {
+    const p = phase orelse return null;
+    return p.end();
+}
@@ -1,158 +1,345 @@
 const std = @import("std");
+const builtin = @import("builtin");
 const tracked_item = @import("tracked_item.zig");
 const c = @cImport({
     @cInclude("testing");
 });
-const testing_types = @import("input_generators.zig");
 const errors = @import("error.zig");
 
 const Allocator = std.mem.Allocator;
 const TrackingObject = tracked_item.TrackingObject;
 const FrameworkError = errors.FrameworkError;
+const Xoshiro256 = std.Random.Xoshiro256;
 
+// Every input gets order_ids 0..size-1 in input order, except where noted.
 pub const TestInputType = enum {
-    Sorted, // Ascending values, ascending order_ids
-    Reversed, // Descending values, ascending order_ids
-    RandomUniqueValues, // Shuffled unique values, ascending order_ids
+    Sorted, // Ascending values
+    Reversed, // Descending values
+    RandomUniqueValues, // Shuffled unique values
     FewUniqueValues, // Many repeated values
-    NearlySorted, // Mostly sorted with a few swaps
+    NearlySorted, // Mostly sorted with a few swaps, ids move with their values
     Empty,
+    OrganPipe, // Ascending to the middle, then descending
+    Sawtooth, // sqrt(size) ascending runs
+    Zipf, // Zipf-distributed duplicates, small values dominate
+    AllEqual, // One value
+    SortedPrefix, // An ascending run over the first half, random after it
+    SortedSuffix, // Random, then an ascending run over the second half
 };
-// Generates TrackingObjects with values 0..size-1, order_ids 0..size-1
-pub fn sorted(allocator: Allocator, size: usize) ![]TrackingObject {
-    if (size == 0) return &[_]TrackingObject{};
-    var arr = try allocator.alloc(TrackingObject, size);
-    errdefer allocator.free(arr);
 
-    var i: usize = 0;
-    while (i < size) : (i += 1) {
-        arr[i] = try TrackingObject.init(@intCast(i), @intCast(i));
+pub const GenerateOptions = struct {
+    /// Threads filling the arena, 0 for one per CPU. Inputs shorter than
+    /// parallel_min_len are always filled on the calling thread.
+    threads: u32 = 0,
+    /// Arenas of at least this many bytes are mapped straight from the
+    /// kernel, with transparent huge pages where available, instead of
+    /// coming from the allocator.
+    mmap_threshold_bytes: usize = 64 << 20,
+    /// Exponent of the Zipf distribution.
+    zipf_exponent: f64 = 1.0,
+};
+
+/// Elements per fill chunk. Each chunk has its own PRNG, seeded from the
+/// input seed and the chunk index, so the contents do not depend on how
+/// many threads filled them.
+const chunk_len = 1 << 16;
+const parallel_min_len = 1 << 20;
+
+/// The generated input as one contiguous array of plain items. Nothing in
+/// it is a TrackedItem allocated by the C side.
+pub const InputArena = struct {
+    items: []c.CTrackedItem,
+    mapping: ?[]align(std.heap.page_size_min) u8 = null,
+    allocator: Allocator,
+
+    pub fn deinit(self: *InputArena) void {
+        if (self.mapping) |mapping| {
+            std.posix.munmap(mapping);
+        } else if (self.items.len > 0) {
+            self.allocator.free(self.items);
+        }
+        self.* = undefined;
     }
-    return arr;
-}
 
-// Generates TrackingObjects with values size-1..0, order_ids 0..size-1
-pub fn reversed(allocator: Allocator, size: usize) ![]TrackingObject {
-    if (size == 0) return &[_]TrackingObject{};
-    var arr = try allocator.alloc(TrackingObject, size);
-    errdefer allocator.free(arr);
+    /// TrackingObject views of the items. They borrow the arena and must
+    /// not be deinitialized; the caller frees the returned slice.
+    pub fn trackingObjects(self: *const InputArena, allocator: Allocator) ![]TrackingObject {
+        const objects = try allocator.alloc(TrackingObject, self.items.len);
+        for (self.items, objects) |*item, *object| object.* = .{ .backing = @ptrCast(item) };
+        return objects;
+    }
+};
 
-    var i: usize = 0;
-    while (i < size) : (i += 1) {
-        arr[i] = try TrackingObject.init(@intCast(size - 1 - i), @intCast(i));
+fn allocateItems(allocator: Allocator, len: usize, options: GenerateOptions) !InputArena {
+    if (len == 0) return .{ .items = &[_]c.CTrackedItem{}, .allocator = allocator };
+    const bytes = len * @sizeOf(c.CTrackedItem);
+    if (builtin.os.tag == .linux and bytes >= options.mmap_threshold_bytes) {
+        const mapping = try std.posix.mmap(
+            null,
+            bytes,
+            std.posix.PROT.READ | std.posix.PROT.WRITE,
+            .{ .TYPE = .PRIVATE, .ANONYMOUS = true },
+            -1,
+            0,
+        );
+        std.posix.madvise(mapping.ptr, mapping.len, std.posix.MADV.HUGEPAGE) catch {};
+        const items: [*]c.CTrackedItem = @ptrCast(mapping.ptr);
+        return .{ .items = items[0..len], .mapping = mapping, .allocator = allocator };
     }
-    return arr;
+    return .{ .items = try allocator.alloc(c.CTrackedItem, len), .allocator = allocator };
+}
+
+/// Uniform integer below bound, by multiply-shift. The bias is below
+/// bound / 2^64, which no test can observe.
+fn below(rng: *Xoshiro256, bound: u64) u64 {
+    return @truncate((@as(u128, rng.next()) * bound) >> 64);
 }
 
-// Generates TrackingObjects with unique values 0..size-1 (shuffled), order_ids 0..size-1
-pub fn randomUniqueValues(allocator: Allocator, size: usize, prng: *std.Random) ![]TrackingObject {
-    if (size == 0) return &[_]TrackingObject{};
-    var arr = try allocator.alloc(TrackingObject, size);
-    errdefer allocator.free(arr);
+fn mix64(x: u64) u64 {
+    var z = x;
+    z = (z ^ (z >> 30)) *% 0xbf58476d1ce4e5b9;
+    z = (z ^ (z >> 27)) *% 0x94d049bb133111eb;
+    return z ^ (z >> 31);
+}
 
-    // Create an array of indices to shuffle for values
-    var values = try allocator.alloc(i32, size);
-    defer allocator.free(values);
-    for (0..size) |i| values[i] = @intCast(i);
-    prng.shuffle(i32, values);
+/// Pseudo-random bijection on [0, n): a four-round Feistel network on the
+/// smallest power of two holding n, cycle-walked back into range. With an
+/// odd number of bits the halves differ by one bit and trade places every
+/// round. Any element can be computed alone, so unlike a shuffle it fills
+/// in parallel and touches no memory beyond the output.
+const Permutation = struct {
+    n: u64,
+    high_bits: u6,
+    low_bits: u6,
+    keys: [4]u64,
 
-    var i: usize = 0;
-    while (i < size) : (i += 1) {
-        arr[i] = try TrackingObject.init(values[i], @intCast(i));
+    fn init(n: u64, seed: u64) Permutation {
+        const bits: u7 = @max(2, std.math.log2_int_ceil(u64, @max(n, 2)));
+        const high_bits: u6 = @intCast((bits + 1) / 2);
+        var keys: [4]u64 = undefined;
+        for (&keys, 0..) |*key, i| key.* = mix64(seed +% i);
+        return .{
+            .n = n,
+            .high_bits = high_bits,
+            .low_bits = @intCast(bits - high_bits),
+            .keys = keys,
+        };
     }
-    return arr;
-}
 
-// Generates TrackingObjects with a few unique values, spread randomly. order_ids 0..size-1
-pub fn fewUniqueValues(allocator: Allocator, size: usize, prng: *std.Random) ![]TrackingObject {
-    if (size == 0) return &[_]TrackingObject{};
+    fn encrypt(self: *const Permutation, x: u64) u64 {
+        var value = x;
+        var high = self.high_bits;
+        var low = self.low_bits;
+        for (self.keys) |key| {
+            const left = value >> low;
+            const right = value & ((@as(u64, 1) << low) - 1);
+            const round = ((right ^ key) *% 0x9e3779b97f4a7c15) >> @intCast(64 - @as(u7, high));
+            value = (right << high) | (left ^ round);
+            std.mem.swap(u6, &high, &low);
+        }
+        return value;
+    }
 
-    var num_distinct_values: usize = @max(1, size / 10);
-    if (num_distinct_values <= 1 and size > 1) {
-        num_distinct_values = 2;
+    fn at(self: *const Permutation, i: u64) u64 {
+        var x = self.encrypt(i);
+        while (x >= self.n) x = self.encrypt(x);
+        return x;
     }
+};
 
-    var arr = try allocator.alloc(TrackingObject, size);
-    errdefer allocator.free(arr);
+/// Zipf sampler over 1..n by rejection-inversion (Hörmann and Derflinger,
+/// "Rejection-inversion to generate variates from monotone discrete
+/// distributions", 1996): O(1) per sample with no table.
+const Zipf = struct {
+    n: f64,
+    exponent: f64,
+    h_integral_x1: f64,
+    h_integral_n: f64,
+    s: f64,
 
-    var i: usize = 0;
-    while (i < size) : (i += 1) {
-        const random_value = prng.intRangeAtMost(i32, 0, @intCast(num_distinct_values - 1));
-        arr[i] = try TrackingObject.init(random_value, @intCast(i));
+    fn init(n: u64, exponent: f64) Zipf {
+        var self = Zipf{ .n = @floatFromInt(n), .exponent = exponent, .h_integral_x1 = 0, .h_integral_n = 0, .s = 0 };
+        self.h_integral_x1 = self.hIntegral(1.5) - 1;
+        self.h_integral_n = self.hIntegral(self.n + 0.5);
+        self.s = 2 - self.hIntegralInverse(self.hIntegral(2.5) - self.h(2));
+        return self;
     }
-    return arr;
-}
 
-// Generates TrackingObjects mostly sorted by value, with a few swaps. order_ids 0..size-1
-pub fn nearlySorted(allocator: Allocator, size: usize, prng: *std.Random) ![]TrackingObject {
-    if (size == 0) return &[_]TrackingObject{};
-    var arr = try sorted(allocator, size); // Starts with sorted values and order_ids
-    errdefer { // Ensure deinit is called on all successfully initialized objects in arr
-        for (arr) |*obj| obj.deinit() catch {}; // Ignore deinit error during cleanup
-        allocator.free(arr);
+    // log1p(x) / x and expm1(x) / x, accurate near 0.
+    fn helper1(x: f64) f64 {
+        if (@abs(x) > 1e-8) return std.math.log1p(x) / x;
+        return 1 - x * (0.5 - x * (1.0 / 3.0 - 0.25 * x));
+    }
+    fn helper2(x: f64) f64 {
+        if (@abs(x) > 1e-8) return std.math.expm1(x) / x;
+        return 1 + x * 0.5 * (1 + x * (1.0 / 3.0) * (1 + 0.25 * x));
     }
 
-    if (size < 2) return arr;
+    fn h(self: *const Zipf, x: f64) f64 {
+        return @exp(-self.exponent * @log(x));
+    }
+    fn hIntegral(self: *const Zipf, x: f64) f64 {
+        const log_x = @log(x);
+        return helper2((1 - self.exponent) * log_x) * log_x;
+    }
+    fn hIntegralInverse(self: *const Zipf, x: f64) f64 {
+        const t = @max(x * (1 - self.exponent), -1);
+        return @exp(helper1(t) * x);
+    }
 
-    const num_swaps: usize = @max(1, size / 20); // Swap about 5% of elements
+    fn sample(self: *const Zipf, rng: *Xoshiro256) u64 {
+        while (true) {
+            const uniform = @as(f64, @floatFromInt(rng.next() >> 11)) * 0x1.0p-53;
+            const u = self.h_integral_n + uniform * (self.h_integral_x1 - self.h_integral_n);
+            const x = self.hIntegralInverse(u);
+            const k = std.math.clamp(@floor(x + 0.5), 1, self.n);
+            if (k - x <= self.s or u >= self.hIntegral(k + 0.5) - self.h(k)) return @intFromFloat(k);
+        }
+    }
+};
 
-    var k: usize = 0;
-    while (k < num_swaps) : (k += 1) {
-        const idx1 = prng.uintAtMost(usize, size - 1);
-        const idx2 = prng.uintAtMost(usize, size - 1);
-        if (idx1 == idx2) continue; // Don't swap with self
+/// Everything a chunk needs to fill itself, computed once per input.
+const FillSpec = struct {
+    n: u64,
+    seed: u64,
+    distinct_values: u64,
+    sawtooth_period: u64,
+    sorted_run_len: u64,
+    permutation: Permutation,
+    zipf: Zipf,
 
-        // Swap the backing handles. The TrackingObject structs themselves are just containers.
-        std.mem.swap(c.TrackedItemHandle, &arr[idx1].backing, &arr[idx2].backing);
+    fn init(input_type: TestInputType, n: u64, seed: u64, options: GenerateOptions) FillSpec {
+        var distinct_values: u64 = @max(1, n / 10);
+        if (distinct_values <= 1 and n > 1) distinct_values = 2;
+        return .{
+            .n = n,
+            .seed = seed,
+            .distinct_values = distinct_values,
+            .sawtooth_period = @max(1, std.math.sqrt(n)),
+            .sorted_run_len = n / 2,
+            .permutation = Permutation.init(if (input_type == .RandomUniqueValues) n else 1, seed),
+            .zipf = Zipf.init(@max(n, 1), if (input_type == .Zipf) options.zipf_exponent else 1.0),
+        };
+    }
+
+    /// The j-th element of an ascending run of run_len random values that
+    /// spans [0, n): one value from each of run_len equal buckets.
+    fn sortedRunValue(self: *const FillSpec, j: u64, rng: *Xoshiro256) u64 {
+        const low = j * self.n / self.sorted_run_len;
+        const high = (j + 1) * self.n / self.sorted_run_len;
+        return low + below(rng, high - low);
     }
-    return arr;
-}
 
-// Deinitializes a slice of TrackingObjects.
-pub fn deinitTrackingObjectSlice(allocator: Allocator, slice: []TrackingObject) void {
-    for (slice) |*item| {
-        // Best effort to deinit. If one fails, we still try others.
-        item.deinit() catch |err| {
-            std.debug.print("Warning: Failed to deinit TrackingObject: {any}\n", .{err});
+    fn value(self: *const FillSpec, comptime input_type: TestInputType, i: u64, rng: *Xoshiro256) u64 {
+        const n = self.n;
+        return switch (input_type) {
+            .Sorted, .NearlySorted => i,
+            .Reversed => n - 1 - i,
+            .RandomUniqueValues => self.permutation.at(i),
+            .FewUniqueValues => below(rng, self.distinct_values),
+            .Empty, .AllEqual => 0,
+            .OrganPipe => if (i < (n + 1) / 2) i else n - 1 - i,
+            .Sawtooth => i % self.sawtooth_period,
+            .Zipf => self.zipf.sample(rng) - 1,
+            .SortedPrefix => if (i < self.sorted_run_len) self.sortedRunValue(i, rng) else below(rng, n),
+            .SortedSuffix => if (i >= n - self.sorted_run_len) self.sortedRunValue(i - (n - self.sorted_run_len), rng) else below(rng, n),
         };
     }
-    allocator.free(slice);
+
+    fn fillChunk(self: *const FillSpec, comptime input_type: TestInputType, items: []c.CTrackedItem, chunk: usize) void {
+        const first = chunk * chunk_len;
+        const last = @min(items.len, first + chunk_len);
+        var rng = Xoshiro256.init(self.seed +% @as(u64, chunk) *% 0x9e3779b97f4a7c15);
+        for (items[first..last], first..) |*item, i| {
+            item.* = .{ .value = @intCast(self.value(input_type, i, &rng)), .order = @intCast(i) };
+        }
+    }
+};
+
+const FillJob = struct {
+    spec: *const FillSpec,
+    input_type: TestInputType,
+    items: []c.CTrackedItem,
+    next_chunk: std.atomic.Value(usize) = std.atomic.Value(usize).init(0),
+
+    fn work(self: *FillJob) void {
+        const chunks = std.math.divCeil(usize, self.items.len, chunk_len) catch unreachable;
+        switch (self.input_type) {
+            inline else => |input_type| {
+                while (true) {
+                    const chunk = self.next_chunk.fetchAdd(1, .monotonic);
+                    if (chunk >= chunks) break;
+                    self.spec.fillChunk(input_type, self.items, chunk);
+                }
+            },
+        }
+    }
+};
+
+fn fill(items: []c.CTrackedItem, input_type: TestInputType, spec: *const FillSpec, options: GenerateOptions) void {
+    var job = FillJob{ .spec = spec, .input_type = input_type, .items = items };
+    const wanted: usize = if (options.threads != 0) options.threads else std.Thread.getCpuCount() catch 1;
+    const workers = if (items.len < parallel_min_len) 1 else @min(wanted, items.len / chunk_len);
+
+    var threads: [64]std.Thread = undefined;
+    var spawned: usize = 0;
+    // If a thread cannot be spawned the others, and this one, take its chunks.
+    while (spawned + 1 < @min(workers, threads.len)) : (spawned += 1) {
+        threads[spawned] = std.Thread.spawn(.{}, FillJob.work, .{&job}) catch break;
+    }
+    job.work();
+    for (threads[0..spawned]) |thread| thread.join();
+}
+
+/// Swaps about 5% of the items, ids and all.
+fn swapSome(items: []c.CTrackedItem, seed: u64) void {
+    if (items.len < 2) return;
+    var rng = Xoshiro256.init(mix64(seed));
+    const num_swaps: usize = @max(1, items.len / 20);
+    for (0..num_swaps) |_| {
+        const idx1 = below(&rng, items.len);
+        const idx2 = below(&rng, items.len);
+        std.mem.swap(c.CTrackedItem, &items[idx1], &items[idx2]);
+    }
 }
 
 // Main function to generate input data based on options.
-// The caller is responsible for deinitializing the returned slice of TrackingObjects
-// and then freeing the slice memory using the allocator.
+// The caller is responsible for calling deinit on the returned arena.
 pub fn generateInputData(
     allocator: Allocator,
     input_type: TestInputType,
     size: c_int,
     prng: *std.Random,
-) FrameworkError![]TrackingObject {
-    const usize_size: usize = @intCast(size);
-    return switch (input_type) {
-        .Empty => sorted(allocator, 0) catch |e| {
-            std.debug.print("Error generating empty input: {any}\n", .{e});
-            return FrameworkError.InputGenerationFailed;
-        },
-        .Sorted => sorted(allocator, usize_size) catch |e| {
-            std.debug.print("Error generating sorted input: {any}\n", .{e});
-            return FrameworkError.InputGenerationFailed;
-        },
-        .Reversed => reversed(allocator, usize_size) catch |e| {
-            std.debug.print("Error generating reversed input: {any}\n", .{e});
-            return FrameworkError.InputGenerationFailed;
-        },
-        .RandomUniqueValues => randomUniqueValues(allocator, usize_size, prng) catch |e| {
-            std.debug.print("Error generating random unique input: {any}\n", .{e});
-            return FrameworkError.InputGenerationFailed;
-        },
-        .FewUniqueValues => fewUniqueValues(allocator, usize_size, prng) catch |e| {
-            std.debug.print("Error generating few unique input: {any}\n", .{e});
-            return FrameworkError.InputGenerationFailed;
-        },
-        .NearlySorted => nearlySorted(allocator, usize_size, prng) catch |e| {
-            std.debug.print("Error generating nearly sorted input: {any}\n", .{e});
-            return FrameworkError.InputGenerationFailed;
-        },
+    options: GenerateOptions,
+) FrameworkError!InputArena {
+    if (size < 0) return FrameworkError.InputGenerationFailed;
+    const len: usize = if (input_type == .Empty) 0 else @intCast(size);
+    var arena = allocateItems(allocator, len, options) catch |e| {
+        std.debug.print("Error allocating {s} input of {d} items: {any}\n", .{ @tagName(input_type), len, e });
+        return FrameworkError.InputGenerationFailed;
     };
+    if (len == 0) return arena;
+
+    const seed = prng.int(u64);
+    const spec = FillSpec.init(input_type, len, seed, options);
+    fill(arena.items, input_type, &spec, options);
+    if (input_type == .NearlySorted) swapSome(arena.items, seed);
+    return arena;
+}
+
+export fn generate_input_values(distribution: c_int, size: c_int, seed: c_ulonglong, values_out: ?[*]c_int) c_int {
+    const input_type = std.meta.intToEnum(TestInputType, distribution) catch return c.ADT_RESULT_ERROR_OTHER;
+    if (size < 0) return c.ADT_RESULT_ERROR_OTHER;
+    if (size > 0 and values_out == null) return c.ADT_RESULT_ERROR_NULL_PTR;
+    var prng_state = std.Random.DefaultPrng.init(seed);
+    var prng = prng_state.random();
+    var input = generateInputData(std.heap.c_allocator, input_type, size, &prng, .{}) catch return c.ADT_RESULT_ERROR_ALLOC;
+    defer input.deinit();
+    for (input.items, 0..) |item, i| values_out.?[i] = item.value;
+    return @intCast(input.items.len);
+}
+
+export fn input_distribution_name(distribution: c_int) [*:0]const u8 {
+    const input_type = std.meta.intToEnum(TestInputType, distribution) catch return "Unknown";
+    return @tagName(input_type);
 }
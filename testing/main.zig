@@ -6,6 +6,8 @@ const logging = @import("logging.zig");
 var gpa = std.heap.GeneralPurposeAllocator(.{}){};
 const global_allocator = gpa.allocator();
 const tracking = @import("tracked_item.zig");
+const perf_counters = @import("perf_counters.zig");
+const heap_stats = @import("heap_stats.zig");
 const TrackingObject = tracking.TrackingObject;
 const InsertionOrder = adt_options.InsertionOrder;
 const Verbosity = adt_options.Verbosity;
@@ -14,6 +16,9 @@ const Complexity = adt_options.Complexity;
 // In case of link errors because (maybe) dead code elimination
 comptime {
     _ = tracking;
+    _ = perf_counters;
+    _ = heap_stats;
+    _ = input_generators;
 }
 
 const adt = @import("adt_simple.zig");
@@ -26,9 +31,15 @@ const AdtSimpleTestingOptions = adt_options.AdtSimpleTestingOptions;
 const errors = @import("error.zig");
 const TestingError = errors.TestingError;
 
+const concurrent_tester = @import("adt_concurrent_tester.zig");
+const benchmark = @import("benchmark.zig");
+const TestSuiteResult = @import("test_results.zig").TestSuiteResult;
+
 const test_runner = @import("test_runner.zig");
 const TestSuite = test_runner.TestSuite;
 const TestRunner = test_runner.TestRunner;
+const input_generators = @import("input_generators.zig");
+const TestInputType = input_generators.TestInputType;
 fn assert_eq(new_value: c_int, old_value: c_int) void {
     if (new_value != old_value) {
         std.debug.print("invalid value, expected:{}, got {}", .{ new_value, old_value });
@@ -66,20 +77,50 @@ fn internal_test_adt(c_adt_ops: *c.adtOperations, c_options: *c.adtSimpleTesting
         .name = std.mem.concat(global_allocator, u8, &.{ options.name, "Basic Ops" }) catch @panic("global alloc go boom"),
         .order = options.order,
         .input_sizes = &[_]c_int{ 5, 10 },
+        .num_iterations = options.num_iterations,
+        .perf_counters = options.perf_counters,
     });
     try test_adt_suite.addCaseConfig(.{
         .name = std.mem.concat(gpa.allocator(), u8, &.{ options.name, "Empty Input" }) catch @panic("global alloc go boom"),
         .order = options.order,
         .input_sizes = &[_]c_int{0},
+        .num_iterations = options.num_iterations,
+        .perf_counters = options.perf_counters,
     });
     try test_adt_suite.addCaseConfig(.{
         .name = std.mem.concat(gpa.allocator(), u8, &.{ options.name, "Random Input" }) catch @panic("global alloc go boom"),
         .order = options.order,
         .input_sizes = &[_]c_int{8},
         .estimate_complexity = true,
+        .num_iterations = options.num_iterations,
+        .perf_counters = options.perf_counters,
+    });
+    try test_adt_suite.addCaseConfig(.{
+        .name = std.mem.concat(gpa.allocator(), u8, &.{ options.name, "Size Sweep" }) catch @panic("global alloc go boom"),
+        .order = options.order,
+        .input_sizes = options.input_sizes,
+        .estimate_complexity = options.estimate_complexity,
+        .max_operations_for_timing = options.max_operations_for_timing,
+        .expected_insert_complexity = options.expected_insert_complexity,
+        .expected_peek_complexity = options.expected_peek_complexity,
+        .expected_remove_complexity = options.expected_remove_complexity,
+        .num_iterations = options.num_iterations,
+        .perf_counters = options.perf_counters,
     });
 
-    var runner = TestRunner.init(global_allocator, 0); // 0 for time-based master_seed
+    const distributions = [_]TestInputType{ .OrganPipe, .Sawtooth, .Zipf, .AllEqual, .SortedPrefix, .SortedSuffix };
+    for (distributions) |input_type| {
+        try test_adt_suite.addCaseConfig(.{
+            .name = std.mem.concat(gpa.allocator(), u8, &.{ options.name, @tagName(input_type) }) catch @panic("global alloc go boom"),
+            .order = options.order,
+            .input_type = input_type,
+            .input_sizes = &[_]c_int{ 1, 100, 1000 },
+            .num_iterations = options.num_iterations,
+        });
+    }
+
+    var runner = TestRunner.init(global_allocator, options.prng_seed); // 0 for time-based master_seed
+    runner.threads = options.threads;
     defer runner.deinit();
 
     try runner.addSuite(&test_adt_suite);
@@ -93,12 +134,33 @@ fn internal_test_adt(c_adt_ops: *c.adtOperations, c_options: *c.adtSimpleTesting
     defer final_results.deinit();
 
     try final_results.printSummary();
+    const failed_tests = final_results.failed_tests;
+
+    if (options.benchmark) {
+        const records = benchmark.run(global_allocator, builder, .{
+            .adt_name = options.name,
+            .input_types = if (options.benchmark_all_inputs) std.enums.values(TestInputType) else &[_]TestInputType{.RandomUniqueValues},
+            .input_sizes = options.input_sizes,
+            .warmup_iterations = options.benchmark_warmup_iterations,
+            .repetitions = options.benchmark_repetitions,
+            .max_operations_for_timing = options.max_operations_for_timing,
+            .pin_cpu = options.benchmark_pin_cpu,
+            .csv_path = options.benchmark_csv_path,
+            .json_path = options.benchmark_json_path,
+        }) catch |err| {
+            try logging.log(.Error, "Benchmark failed: {any}\n", .{err});
+            return error.TestLogicError;
+        };
+        global_allocator.free(records);
+    }
+
     if (gpa.deinit() == .leak) {
         try logging.log(.Warning, "Memory leak detected by GeneralPurposeAllocator at end of main!\n", .{});
     } else {
         try logging.log(.Warning, "GPA deinitialized successfully. No leaks reported by GPA.\n", .{});
     }
     try logging.log(.Warning, "ADT Testing Framework finished.\n", .{});
+    if (failed_tests > 0) return error.VerificationFailed;
 }
 export fn default_adtSimpleTestingOptions(name: [*c]u8) c.adtSimpleTestingOptions {
     const initial_values = [_]c_int{ 10, 50, 100, 200, 500, 1000, 2000, 5000, 10000 };
@@ -111,10 +173,87 @@ export fn default_adtSimpleTestingOptions(name: [*c]u8) c.adtSimpleTestingOption
         .order = @intFromEnum(InsertionOrder.Unknown),
         .sorted_output = true,
         .input_sizes = @ptrCast(defaultSizes.ptr),
-        .input_sizes_size = 9,
+        .input_sizes_size = initial_values.len,
         .estimate_complexity = true,
         .expected_insert_complexity = @intFromEnum(Complexity.None),
         .expected_peek_complexity = @intFromEnum(Complexity.None),
         .expected_remove_complexity = @intFromEnum(Complexity.None),
+        .num_iterations = 1,
+        .max_operations_for_timing = 10000,
+        .perf_counters = false,
+        .test_threads = 1,
+        .seed = 0,
+        .benchmark = false,
+        .benchmark_warmup_iterations = 2,
+        .benchmark_repetitions = 10,
+        .benchmark_all_inputs = false,
+        .benchmark_pin_cpu = -1,
+        .benchmark_csv_path = null,
+        .benchmark_json_path = null,
+    };
+}
+
+export fn test_adt_concurrent(c_adt_ops: *c.adtOperations, c_options: *c.adtConcurrentTestingOptions) c_int {
+    internal_test_adt_concurrent(c_adt_ops, c_options) catch |terr| {
+        return errors.testingErrorToCInt(terr);
+    };
+    return 0;
+}
+fn internal_test_adt_concurrent(c_adt_ops: *c.adtOperations, c_options: *c.adtConcurrentTestingOptions) TestingError!void {
+    // The worker threads allocate concurrently, and the GPA above is torn
+    // down at the end of every test_adt call, so use the C allocator here.
+    const allocator = std.heap.c_allocator;
+    const name = std.mem.span(c_options.name);
+    if (c_options.thread_counts_size < 0 or c_options.items_per_producer < 0) return error.InvalidInputConfiguration;
+    const thread_counts = c_options.thread_counts[0..@intCast(c_options.thread_counts_size)];
+
+    var suite_result = TestSuiteResult.init(name, allocator);
+    defer suite_result.deinit();
+    var case_names = std.ArrayList([]u8).init(allocator);
+    defer {
+        for (case_names.items) |case_name| allocator.free(case_name);
+        case_names.deinit();
+    }
+
+    const builder = ADTSimpleBuilder.init(c_adt_ops);
+    for (thread_counts) |thread_count| {
+        if (thread_count <= 0) return error.InvalidInputConfiguration;
+        const case_name = std.fmt.allocPrint(allocator, "{s} {d}x{d} threads", .{ name, thread_count, thread_count }) catch return error.Alloc;
+        case_names.append(case_name) catch {
+            allocator.free(case_name);
+            return error.Alloc;
+        };
+        const case_result = switch (c_options.order) {
+            c.SortedValue => concurrent_tester.runPriorityCase(allocator, builder, .{
+                .name = case_name,
+                .threads = @intCast(thread_count),
+                .items_per_thread = @intCast(c_options.items_per_producer),
+                .seed = @intCast(thread_count),
+            }),
+            c.FirstInFirstOut => concurrent_tester.runConcurrentCase(allocator, builder, .{
+                .name = case_name,
+                .producers = @intCast(thread_count),
+                .consumers = @intCast(thread_count),
+                .items_per_producer = @intCast(c_options.items_per_producer),
+            }),
+            else => return error.InvalidInputConfiguration,
+        } catch return error.TestLogicError;
+        suite_result.addResult(case_result) catch return error.Alloc;
+    }
+
+    try suite_result.printSummary();
+    if (suite_result.failed_tests > 0) return error.VerificationFailed;
+}
+export fn default_adtConcurrentTestingOptions(name: [*c]u8) c.adtConcurrentTestingOptions {
+    const initial_counts = [_]c_int{ 1, 2, 4, 8 };
+    const default_counts = std.heap.c_allocator.dupe(c_int, &initial_counts) catch |err| {
+        std.debug.panic("C allocator hit the fan: {any}", .{err});
+    };
+    return .{
+        .name = name,
+        .thread_counts = @ptrCast(default_counts.ptr),
+        .thread_counts_size = initial_counts.len,
+        .items_per_producer = 100_000,
+        .order = c.FirstInFirstOut,
     };
 }
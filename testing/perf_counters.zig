@@ -0,0 +1,200 @@
+const std = @import("std");
+const builtin = @import("builtin");
+const linux = std.os.linux;
+
+/// Counts of one measured region, laid out like the C PerfCounts in
+/// testing.h. Events the kernel or CPU could not count stay -1.
+pub const PerfCounts = extern struct {
+    cycles: i64 = -1,
+    instructions: i64 = -1,
+    l1d_read_misses: i64 = -1,
+    llc_read_misses: i64 = -1,
+    branch_misses: i64 = -1,
+    dtlb_read_misses: i64 = -1,
+
+    /// Events per operation, or null if the event was not counted.
+    pub fn perOp(value: i64, operations: u64) ?f64 {
+        if (value < 0) return null;
+        return @as(f64, @floatFromInt(value)) / @as(f64, @floatFromInt(@max(operations, 1)));
+    }
+};
+
+// The parts of linux/perf_event.h used here. The attribute struct is the
+// original 64-byte PERF_ATTR_SIZE_VER0 layout, which every kernel accepts.
+const PerfEventAttr = extern struct {
+    type: u32,
+    size: u32 = @sizeOf(PerfEventAttr),
+    config: u64,
+    sample_period: u64 = 0,
+    sample_type: u64 = 0,
+    read_format: u64 = 0,
+    flags: u64 = 0,
+    wakeup_events: u32 = 0,
+    bp_type: u32 = 0,
+    config1: u64 = 0,
+};
+comptime {
+    std.debug.assert(@sizeOf(PerfEventAttr) == 64);
+}
+
+const type_hardware = 0;
+const type_hw_cache = 3;
+const flag_disabled = 1 << 0;
+const flag_exclude_kernel = 1 << 5;
+const flag_exclude_hv = 1 << 6;
+const format_total_time_enabled = 1 << 0;
+const format_total_time_running = 1 << 1;
+const format_group = 1 << 3;
+const open_flag_cloexec = 1 << 3;
+const ioc_enable = 0x2400;
+const ioc_disable = 0x2401;
+const ioc_reset = 0x2403;
+const ioc_flag_group = 1;
+
+/// PERF_TYPE_HW_CACHE config for read misses of the given cache.
+fn readMisses(cache: u64) u64 {
+    const op_read = 0;
+    const result_miss = 1;
+    return cache | (op_read << 8) | (result_miss << 16);
+}
+
+const Event = struct {
+    field: []const u8,
+    type: u32,
+    config: u64,
+};
+
+const events = [_]Event{
+    .{ .field = "cycles", .type = type_hardware, .config = 0 },
+    .{ .field = "instructions", .type = type_hardware, .config = 1 },
+    .{ .field = "l1d_read_misses", .type = type_hw_cache, .config = readMisses(0) },
+    .{ .field = "llc_read_misses", .type = type_hw_cache, .config = readMisses(2) },
+    .{ .field = "branch_misses", .type = type_hardware, .config = 5 },
+    .{ .field = "dtlb_read_misses", .type = type_hw_cache, .config = readMisses(3) },
+};
+
+pub const OpenError = error{ Unsupported, PermissionDenied, NoHardwareCounters, Unavailable };
+
+/// One perf_event_open group counting the calling thread in user space.
+/// The events are scheduled together, so every count in a PerfCounts
+/// covers the same instructions. Events the CPU lacks are left out of the
+/// group rather than failing it.
+pub const PerfGroup = struct {
+    fds: [events.len]i32 = [_]i32{-1} ** events.len,
+    /// Index of each event's value in a group read, null if it did not open.
+    slots: [events.len]?u8 = [_]?u8{null} ** events.len,
+    opened: u8 = 0,
+    leader: i32 = -1,
+
+    /// Fails when no event at all can be opened: no PMU (most VMs and
+    /// containers), perf_event_paranoid too strict, or a non-Linux host.
+    pub fn open() OpenError!PerfGroup {
+        if (builtin.os.tag != .linux) return error.Unsupported;
+        var group = PerfGroup{};
+        var first_error: ?OpenError = null;
+        for (events, 0..) |event, i| {
+            var attr = PerfEventAttr{
+                .type = event.type,
+                .config = event.config,
+                .read_format = format_group | format_total_time_enabled | format_total_time_running,
+                .flags = flag_exclude_kernel | flag_exclude_hv | @as(u64, if (group.leader == -1) flag_disabled else 0),
+            };
+            const rc = linux.syscall5(
+                .perf_event_open,
+                @intFromPtr(&attr),
+                0, // this thread
+                @bitCast(@as(isize, -1)), // on any CPU
+                @bitCast(@as(isize, group.leader)),
+                open_flag_cloexec,
+            );
+            switch (linux.E.init(rc)) {
+                .SUCCESS => {
+                    const fd: i32 = @intCast(rc);
+                    if (group.leader == -1) group.leader = fd;
+                    group.fds[i] = fd;
+                    group.slots[i] = group.opened;
+                    group.opened += 1;
+                },
+                .ACCES, .PERM => first_error = first_error orelse error.PermissionDenied,
+                .NOENT, .OPNOTSUPP, .NODEV, .NOSYS => first_error = first_error orelse error.NoHardwareCounters,
+                else => first_error = first_error orelse error.Unavailable,
+            }
+        }
+        if (group.leader == -1) return first_error orelse error.Unavailable;
+        return group;
+    }
+
+    pub fn close(self: *PerfGroup) void {
+        for (&self.fds) |*fd| {
+            if (fd.* >= 0) _ = linux.close(fd.*);
+            fd.* = -1;
+        }
+        self.leader = -1;
+    }
+
+    fn ioctl(self: *const PerfGroup, request: u32) void {
+        _ = linux.syscall3(.ioctl, @intCast(self.leader), request, ioc_flag_group);
+    }
+
+    pub fn start(self: *const PerfGroup) void {
+        self.ioctl(ioc_reset);
+        self.ioctl(ioc_enable);
+    }
+
+    /// Stops counting and returns the counts since start(). If the kernel
+    /// had to multiplex the group, counts are scaled up to the full region.
+    pub fn stop(self: *const PerfGroup) PerfCounts {
+        self.ioctl(ioc_disable);
+        var counts = PerfCounts{};
+        // nr, time_enabled, time_running, then one value per event.
+        var buffer: [3 + events.len]u64 = undefined;
+        const rc = linux.read(self.leader, @ptrCast(&buffer), @sizeOf(@TypeOf(buffer)));
+        if (linux.E.init(rc) != .SUCCESS or rc < 3 * @sizeOf(u64)) return counts;
+        const nr = buffer[0];
+        const enabled = buffer[1];
+        const running = buffer[2];
+        // A group that never got onto the PMU has nothing to report.
+        if (running == 0) return counts;
+        inline for (events, 0..) |event, i| {
+            if (self.slots[i]) |slot| {
+                if (slot < nr) {
+                    const raw: u128 = buffer[3 + slot];
+                    const scaled = if (running < enabled) raw * enabled / running else raw;
+                    @field(counts, event.field) = @intCast(@min(scaled, std.math.maxInt(i64)));
+                }
+            }
+        }
+        return counts;
+    }
+};
+
+fn fromHandle(handle: *anyopaque) *PerfGroup {
+    return @ptrCast(@alignCast(handle));
+}
+
+export fn perf_counters_open() ?*anyopaque {
+    var group = PerfGroup.open() catch return null;
+    const boxed = std.heap.c_allocator.create(PerfGroup) catch {
+        group.close();
+        return null;
+    };
+    boxed.* = group;
+    return boxed;
+}
+
+export fn perf_counters_start(handle: ?*anyopaque) void {
+    if (handle) |h| fromHandle(h).start();
+}
+
+export fn perf_counters_stop(handle: ?*anyopaque) PerfCounts {
+    if (handle) |h| return fromHandle(h).stop();
+    return .{};
+}
+
+export fn perf_counters_close(handle: ?*anyopaque) void {
+    if (handle) |h| {
+        const group = fromHandle(h);
+        group.close();
+        std.heap.c_allocator.destroy(group);
+    }
+}
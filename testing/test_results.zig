@@ -3,6 +3,7 @@ const testing_types = @import("adt_options.zig");
 const errors = @import("error.zig");
 const logging = @import("logging.zig");
 const TestMeasurement = testing_types.TestMeasurement;
+const PerfCounts = @import("perf_counters.zig").PerfCounts;
 const TestFailure = testing_types.TestFailure;
 const Verbosity = testing_types.Verbosity;
 const Allocator = std.mem.Allocator;
@@ -13,9 +14,10 @@ pub const TestCaseResult = struct {
     failure: ?TestFailure = null,
     measurements: std.ArrayList(TestMeasurement),
     allocator: Allocator,
+    /// The name is copied, callers may pass a temporary buffer.
     pub fn init(name: []const u8, allocator: Allocator) TestCaseResult {
         return .{
-            .name = name,
+            .name = allocator.dupe(u8, name) catch @panic("failed to allocate test case name"),
             .passed = true,
             .measurements = std.ArrayList(TestMeasurement).init(allocator),
             .allocator = allocator,
@@ -26,6 +28,7 @@ pub const TestCaseResult = struct {
         if (self.failure) |*f| {
             f.deinit(self.allocator);
         }
+        self.allocator.free(self.name);
         self.measurements.deinit();
     }
 
@@ -72,6 +75,35 @@ pub const TestCaseResult = struct {
                 try logging.log(verbosity, "      - Op: {s}, N: {d}, Time: {d}ns, Count: {d}", .{
                     m.operation, m.input_size_n, m.duration_ns, m.operations_count,
                 });
+                if (m.allocations) |allocations| {
+                    const ops: f64 = @floatFromInt(@max(m.operations_count, 1));
+                    const heap_allocations = m.heap_allocations orelse 0;
+                    try logging.log(verbosity, "        Allocator: {d} calls ({d:.3}/op), heap: {d} ({d:.3}/op)", .{
+                        allocations,      @as(f64, @floatFromInt(allocations)) / ops,
+                        heap_allocations, @as(f64, @floatFromInt(heap_allocations)) / ops,
+                    });
+                }
+                if (m.heap) |heap| {
+                    const ops: f64 = @floatFromInt(@max(m.operations_count, 1));
+                    try logging.log(verbosity, "        Heap: {d} allocs ({d:.3}/op), {d} frees, {d} bytes allocated ({d:.1}/op), {d} freed, peak {d} bytes live", .{
+                        heap.allocations,
+                        @as(f64, @floatFromInt(heap.allocations)) / ops,
+                        heap.frees,
+                        heap.bytes_allocated,
+                        @as(f64, @floatFromInt(heap.bytes_allocated)) / ops,
+                        heap.bytes_freed,
+                        heap.peak_live_bytes,
+                    });
+                }
+                if (m.counters) |counts| {
+                    const per_op = PerfCounts.perOp;
+                    const ops = m.operations_count;
+                    try logging.log(verbosity, "        Per op: cycles {?d:.1}, instructions {?d:.1}, L1D misses {?d:.3}, LLC misses {?d:.3}, branch misses {?d:.3}, dTLB misses {?d:.3}", .{
+                        per_op(counts.cycles, ops),        per_op(counts.instructions, ops),
+                        per_op(counts.l1d_read_misses, ops), per_op(counts.llc_read_misses, ops),
+                        per_op(counts.branch_misses, ops), per_op(counts.dtlb_read_misses, ops),
+                    });
+                }
             }
         }
     }
@@ -6,6 +6,7 @@ const adt = @import("adt_simple.zig");
 const tracked_item = @import("tracked_item.zig");
 const errors = @import("error.zig");
 const logging = @import("logging.zig");
+const complexity = @import("complexity.zig");
 const TestingError = errors.TestingError;
 const AdtTestingOptions = testing_types.AdtSimpleTestingOptions;
 const TestCaseResult = test_results.TestCaseResult;
@@ -16,6 +17,7 @@ const Verbosity = testing_types.Verbosity;
 const InsertionOrder = testing_types.InsertionOrder;
 const Complexity = testing_types.Complexity;
 const TestInputType = @import("input_generators.zig").TestInputType;
+const TestMeasurement = testing_types.TestMeasurement;
 pub const TestOptions = struct {
     name: []const u8 = "Unnamed ADT Test Case",
     verbosity: Verbosity = .Info,
@@ -29,9 +31,16 @@ pub const TestOptions = struct {
     expected_insert_complexity: Complexity = .Undetermined,
     expected_peek_complexity: Complexity = .Undetermined,
     expected_remove_complexity: Complexity = .Undetermined,
+    /// Fits below this confidence never fail a test, see complexity.zig.
+    complexity_min_confidence: f64 = complexity.default_min_confidence,
     num_iterations: u32 = 1,
+    /// Collect hardware counters around each timed phase.
+    perf_counters: bool = false,
     timeout_ms: ?u64 = 5000,
     fail_fast: bool = false,
+    /// Never run concurrently with other cases. Cases that estimate
+    /// complexity or read hardware counters always run alone.
+    exclusive: bool = false,
 };
 pub const TestSuiteOptions = struct {
     verbosity: Verbosity = .Info,
@@ -78,20 +87,22 @@ pub const TestSuite = struct {
 
 pub const TestRunner = struct {
     allocator: Allocator,
-    prng_master: std.Random,
+    master_seed: u64,
+    /// Worker threads for cases that may share the machine with others.
+    /// 0 starts one per CPU, 1 runs every case on the calling thread.
+    threads: u32 = 1,
     suites_to_run: std.ArrayList(*TestSuite),
     pub fn init(allocator: Allocator, master_seed: u64) TestRunner {
-        var seeded_prng = std.Random.DefaultPrng.init(master_seed);
+        var seed = master_seed;
         if (master_seed == 0) {
-            const time_seed: usize = @intCast(std.time.nanoTimestamp());
-            seeded_prng = std.Random.DefaultPrng.init(time_seed);
-            std.debug.print("Initialized TestRunner PRNG with time-based seed: {d}\n", .{time_seed});
+            seed = @truncate(@as(u128, @bitCast(std.time.nanoTimestamp())));
+            std.debug.print("Initialized TestRunner PRNG with time-based seed: {d}\n", .{seed});
         } else {
             std.debug.print("Initialized TestRunner PRNG with fixed seed: {d}\n", .{master_seed});
         }
         return .{
             .allocator = allocator,
-            .prng_master = seeded_prng.random(),
+            .master_seed = seed,
             .suites_to_run = std.ArrayList(*TestSuite).init(allocator),
         };
     }
@@ -109,29 +120,119 @@ pub const TestRunner = struct {
         };
     }
 
+    fn workerCount(self: @This()) usize {
+        if (self.threads != 0) return self.threads;
+        return std.Thread.getCpuCount() catch 1;
+    }
+
+    /// Runs every case of every suite. All cases are planned, and their
+    /// seeds drawn from the master seed, before any of them runs, so a
+    /// case gets the same seed and the suites the same results whether the
+    /// cases run one by one or on a thread pool.
     pub fn runAll(self: @This()) !TestSuiteResult {
         var overall_run_result = TestSuiteResult.init("Overall Test Run Summary", self.allocator);
+        errdefer overall_run_result.deinit();
 
-        for (self.suites_to_run.items) |suite_ptr| {
-            const suite = suite_ptr.*;
-            var suite_result = TestSuiteResult.init(suite.name, self.allocator);
+        var plan = try RunPlan.init(self.allocator, self.suites_to_run.items, self.master_seed);
+        defer plan.deinit();
 
-            const suite_verbosity = suite.options.verbosity;
+        const workers = self.workerCount();
+        if (workers > 1) {
+            try logging.log(.Info, "\n=== Running {d} test cases on {d} threads ===\n", .{ plan.jobs.len, workers });
+            // Suites overlap, so the TrackedItem stats cover the whole run.
+            var reset_stats = false;
+            var print_stats = false;
+            for (self.suites_to_run.items) |suite_ptr| {
+                reset_stats = reset_stats or suite_ptr.options.reset_stats_before_suite;
+                print_stats = print_stats or suite_ptr.options.print_stats_after_suite;
+            }
+            if (reset_stats) _ = tracked_item.resetStats();
+            try plan.runParallel(workers);
+            for (self.suites_to_run.items, plan.suite_ranges) |suite_ptr, range| {
+                try logging.log(.Info, "\n=== Test Suite: {s} ===\n", .{suite_ptr.name});
+                try collectSuite(self.allocator, suite_ptr, plan.jobs[range.start..range.end], &overall_run_result);
+            }
+            if (print_stats) {
+                try logging.log(.Debug, "  TrackedItem stats after all suites:\n", .{});
+                tracked_item.printStats();
+            }
+            return overall_run_result;
+        }
+
+        for (self.suites_to_run.items, plan.suite_ranges) |suite_ptr, range| {
+            const suite = suite_ptr.*;
             try logging.log(.Info, "\n=== Running Test Suite: {s} ===\n", .{suite.name});
 
             if (suite.options.reset_stats_before_suite) {
                 try logging.log(.Debug, "  Resetting TrackedItem stats before suite.\n", .{});
                 _ = tracked_item.resetStats();
             }
+            for (range.start..range.end) |index| plan.runJob(index);
+            try collectSuite(self.allocator, suite_ptr, plan.jobs[range.start..range.end], &overall_run_result);
+            if (suite.options.print_stats_after_suite) {
+                try logging.log(.Debug, "  TrackedItem stats after suite '{s}':\n", .{suite.name});
+                tracked_item.printStats();
+            }
+        }
+        return overall_run_result;
+    }
+};
+
+/// Timing-sensitive cases measure nothing useful next to other cases, so
+/// the parallel runner runs them alone after the rest.
+fn runsAlone(config: TestOptions) bool {
+    return config.exclusive or config.estimate_complexity or config.perf_counters;
+}
 
-            for (suite.test_case_configs.items) |base_config| {
-                END_SUITE_CONFIG_LOOP: for (base_config.input_sizes) |current_n_size| {
+const no_failure = std.math.maxInt(usize);
+
+/// One run of one case config at one input size.
+const CaseJob = struct {
+    suite: *const TestSuite,
+    suite_index: usize,
+    /// Index into RunPlan.config_failures, unique across suites.
+    config_index: usize,
+    base_config: *const TestOptions,
+    options: TestOptions,
+    name: []u8,
+    size: c_int,
+    seed: u64,
+    exclusive: bool,
+    result: ?TestCaseResult = null,
+};
+
+const JobRange = struct { start: usize, end: usize };
+
+const RunPlan = struct {
+    allocator: Allocator,
+    jobs: []CaseJob,
+    suite_ranges: []JobRange,
+    /// Lowest index of a failed job that stops the rest of its config or
+    /// suite. Jobs past it are skipped, jobs before it still run, which is
+    /// what the sequential runner would have done.
+    config_failures: []std.atomic.Value(usize),
+    suite_failures: []std.atomic.Value(usize),
+
+    fn init(allocator: Allocator, suites: []const *TestSuite, master_seed: u64) !RunPlan {
+        var prng = std.Random.DefaultPrng.init(master_seed);
+        const random = prng.random();
+
+        var jobs = std.ArrayList(CaseJob).init(allocator);
+        defer jobs.deinit();
+        errdefer for (jobs.items) |job| allocator.free(job.name);
+        const suite_ranges = try allocator.alloc(JobRange, suites.len);
+        errdefer allocator.free(suite_ranges);
+
+        var config_count: usize = 0;
+        for (suites, suite_ranges, 0..) |suite, *range, suite_index| {
+            range.start = jobs.items.len;
+            const suite_verbosity = suite.options.verbosity;
+            for (suite.test_case_configs.items) |*base_config| {
+                for (base_config.input_sizes) |current_n_size| {
                     var iteration: u32 = 0;
                     while (iteration < base_config.num_iterations) : (iteration += 1) {
-                        var current_run_options = base_config;
-                        var case_run_name_buf: [256]u8 = undefined;
-                        const case_run_name = if (base_config.num_iterations > 1)
-                            try std.fmt.bufPrint(&case_run_name_buf, "{s} (N={d}, {s}, Iter {d}/{d})", .{
+                        const name = if (base_config.num_iterations > 1)
+                            try std.fmt.allocPrint(allocator, "{s} (N={d}, {s}, Iter {d}/{d})", .{
                                 base_config.name,
                                 current_n_size,
                                 @tagName(base_config.input_type),
@@ -139,68 +240,234 @@ pub const TestRunner = struct {
                                 base_config.num_iterations,
                             })
                         else
-                            try std.fmt.bufPrint(&case_run_name_buf, "{s} (N={d}, {s})", .{
+                            try std.fmt.allocPrint(allocator, "{s} (N={d}, {s})", .{
                                 base_config.name,
                                 current_n_size,
                                 @tagName(base_config.input_type),
                             });
+                        errdefer allocator.free(name);
 
-                        current_run_options.name = case_run_name;
-                        current_run_options.input_sizes = &[_]c_int{current_n_size};
-                        current_run_options.verbosity = @enumFromInt(@max(@intFromEnum(base_config.verbosity), @intFromEnum(suite_verbosity)));
-                        var case_prng_seed = self.prng_master.int(u64);
+                        var case_prng_seed = random.int(u64);
                         if (base_config.prng_seed != 0) {
                             case_prng_seed ^= base_config.prng_seed;
                         }
-                        case_prng_seed += iteration;
-                        var rand = std.Random.DefaultPrng.init(case_prng_seed);
-                        var case_prng_instance = rand.random();
-
-                        try logging.log(.Trace, "    Starting test case: {s} with PRNG seed: {d}\n", .{ case_run_name, case_prng_seed });
-
-                        const individual_case_result = adt_tester.runAdtTestCase(
-                            self.allocator,
-                            suite.adt_builder,
-                            current_run_options,
-                            &case_prng_instance,
-                        ) catch |err| {
-                            var temp_err_result = TestCaseResult.init(current_run_options.name, self.allocator);
-                            defer temp_err_result.deinit();
-                            var err_msg_buf: [128]u8 = undefined;
-                            var err_fbs = std.io.fixedBufferStream(&err_msg_buf);
-                            errors.formatError(err, err_fbs.writer()) catch {};
-                            temp_err_result.recordFailure("Test case execution framework error", err_fbs.getWritten(), null, null);
-
-                            try suite_result.addResult(temp_err_result);
-                            if (current_run_options.fail_fast or suite.options.fail_fast_suite) {
-                                break;
-                            }
-                            continue;
-                        };
-
-                        try suite_result.addResult(individual_case_result);
-
-                        if (!individual_case_result.passed and (current_run_options.fail_fast or suite.options.fail_fast_suite)) {
-                            try logging.log(.Warning, "  FAIL_FAST triggered for: {s}. Stopping further tests in this config/suite.\n", .{current_run_options.name});
-                            break :END_SUITE_CONFIG_LOOP;
-                        }
+                        case_prng_seed +%= iteration;
+
+                        var options = base_config.*;
+                        options.name = name;
+                        options.verbosity = @enumFromInt(@max(@intFromEnum(base_config.verbosity), @intFromEnum(suite_verbosity)));
+                        try jobs.append(.{
+                            .suite = suite,
+                            .suite_index = suite_index,
+                            .config_index = config_count,
+                            .base_config = base_config,
+                            .options = options,
+                            .name = name,
+                            .size = current_n_size,
+                            .seed = case_prng_seed,
+                            .exclusive = runsAlone(base_config.*),
+                        });
                     }
                 }
-                if (suite_result.failed_tests > 0 and suite.options.fail_fast_suite) {
-                    break;
-                }
+                config_count += 1;
             }
-            if (suite.options.print_stats_after_suite) {
-                try logging.log(.Debug, "  TrackedItem stats after suite '{s}':\n", .{suite.name});
-                tracked_item.printStats();
+            range.end = jobs.items.len;
+        }
+
+        const config_failures = try allocator.alloc(std.atomic.Value(usize), config_count);
+        errdefer allocator.free(config_failures);
+        const suite_failures = try allocator.alloc(std.atomic.Value(usize), suites.len);
+        errdefer allocator.free(suite_failures);
+        for (config_failures) |*f| f.* = std.atomic.Value(usize).init(no_failure);
+        for (suite_failures) |*f| f.* = std.atomic.Value(usize).init(no_failure);
+
+        return .{
+            .allocator = allocator,
+            .jobs = try jobs.toOwnedSlice(),
+            .suite_ranges = suite_ranges,
+            .config_failures = config_failures,
+            .suite_failures = suite_failures,
+        };
+    }
+
+    fn deinit(self: *RunPlan) void {
+        for (self.jobs) |*job| {
+            if (job.result) |*result| result.deinit();
+            self.allocator.free(job.name);
+        }
+        self.allocator.free(self.jobs);
+        self.allocator.free(self.suite_ranges);
+        self.allocator.free(self.config_failures);
+        self.allocator.free(self.suite_failures);
+    }
+
+    fn lowerTo(failure: *std.atomic.Value(usize), index: usize) void {
+        var current = failure.load(.monotonic);
+        while (index < current) {
+            current = failure.cmpxchgWeak(current, index, .acq_rel, .monotonic) orelse return;
+        }
+    }
+
+    /// Runs one job, unless an earlier job already stopped its config or
+    /// suite. Safe to call from several threads for different jobs.
+    fn runJob(self: *RunPlan, index: usize) void {
+        const job = &self.jobs[index];
+        if (index > self.config_failures[job.config_index].load(.acquire) or
+            index > self.suite_failures[job.suite_index].load(.acquire)) return;
+
+        var options = job.options;
+        options.input_sizes = (&job.size)[0..1];
+        var rand = std.Random.DefaultPrng.init(job.seed);
+        var case_prng_instance = rand.random();
+
+        logging.log(.Trace, "    Starting test case: {s} with PRNG seed: {d}\n", .{ job.name, job.seed }) catch {};
+
+        const result = adt_tester.runAdtTestCase(
+            self.allocator,
+            job.suite.adt_builder,
+            options,
+            &case_prng_instance,
+        ) catch |err| frameworkErrorResult(self.allocator, job.name, err);
+
+        if (!result.passed) {
+            const fail_fast_suite = job.suite.options.fail_fast_suite;
+            if (options.fail_fast or fail_fast_suite) lowerTo(&self.config_failures[job.config_index], index);
+            if (fail_fast_suite) lowerTo(&self.suite_failures[job.suite_index], index);
+        }
+        job.result = result;
+    }
+
+    /// Runs the jobs on a thread pool, then the ones that must run alone on
+    /// the calling thread, in order.
+    fn runParallel(self: *RunPlan, workers: usize) !void {
+        {
+            var pool: std.Thread.Pool = undefined;
+            // The calling thread works through the queue as well.
+            try pool.init(.{ .allocator = self.allocator, .n_jobs = @intCast(workers - 1) });
+            defer pool.deinit();
+            var wait_group: std.Thread.WaitGroup = .{};
+            for (self.jobs, 0..) |*job, index| {
+                if (!job.exclusive) pool.spawnWg(&wait_group, runJob, .{ self, index });
             }
+            pool.waitAndWork(&wait_group);
+        }
+        for (self.jobs, 0..) |*job, index| {
+            if (job.exclusive) self.runJob(index);
+        }
+    }
+};
 
-            try suite_result.printSummary();
-            overall_run_result.total_tests += suite_result.total_tests;
-            overall_run_result.passed_tests += suite_result.passed_tests;
-            overall_run_result.failed_tests += suite_result.failed_tests;
-            suite_result.deinit();
+fn frameworkErrorResult(allocator: Allocator, name: []const u8, err: anyerror) TestCaseResult {
+    var result = TestCaseResult.init(name, allocator);
+    var err_msg_buf: [128]u8 = undefined;
+    var err_fbs = std.io.fixedBufferStream(&err_msg_buf);
+    errors.formatError(err, err_fbs.writer()) catch {};
+    result.recordFailure("Test case execution framework error", err_fbs.getWritten(), null, null);
+    return result;
+}
+
+/// Moves the results of one suite's jobs, in plan order, into a suite
+/// result, applies fail-fast the way a sequential run would have, prints
+/// the summary and adds the counts to overall.
+fn collectSuite(allocator: Allocator, suite: *const TestSuite, jobs: []CaseJob, overall: *TestSuiteResult) !void {
+    var suite_result = TestSuiteResult.init(suite.name, allocator);
+    defer suite_result.deinit();
+
+    var index: usize = 0;
+    while (index < jobs.len) {
+        const config_index = jobs[index].config_index;
+        const base_config = jobs[index].base_config.*;
+        const first_case_of_config = suite_result.case_results.items.len;
+        var stopped = false;
+        while (index < jobs.len and jobs[index].config_index == config_index) : (index += 1) {
+            const job = &jobs[index];
+            if (stopped) continue;
+            // Left to RunPlan.deinit if not taken.
+            const result = job.result orelse continue;
+            try suite_result.addResult(result);
+            job.result = null;
+            if (!result.passed and (job.options.fail_fast or suite.options.fail_fast_suite)) {
+                try logging.log(.Warning, "  FAIL_FAST triggered for: {s}. Stopping further tests in this config/suite.\n", .{job.name});
+                stopped = true;
+            }
+        }
+        if (base_config.estimate_complexity) {
+            const config_results = suite_result.case_results.items[first_case_of_config..];
+            if (try evaluateComplexity(allocator, base_config, config_results)) |fit_result| {
+                try suite_result.addResult(fit_result);
+            }
+        }
+        if (suite_result.failed_tests > 0 and suite.options.fail_fast_suite) {
+            break;
         }
-        return overall_run_result;
     }
+
+    try suite_result.printSummary();
+    overall.total_tests += suite_result.total_tests;
+    overall.passed_tests += suite_result.passed_tests;
+    overall.failed_tests += suite_result.failed_tests;
+}
+
+const ComplexityCheck = struct {
+    operation: []const u8,
+    label: []const u8,
+    expected: Complexity,
 };
+
+/// Fits the time per operation measured over every size of one case config
+/// and returns a result that fails if a confident fit disagrees with the
+/// declared complexity. Returns null if no operation had enough sizes.
+fn evaluateComplexity(allocator: Allocator, config: TestOptions, case_results: []const TestCaseResult) !?TestCaseResult {
+    var measurements = std.ArrayList(TestMeasurement).init(allocator);
+    defer measurements.deinit();
+    for (case_results) |case_result| try measurements.appendSlice(case_result.measurements.items);
+
+    const checks = [_]ComplexityCheck{
+        .{ .operation = "insert_all", .label = "insert", .expected = config.expected_insert_complexity },
+        .{ .operation = "peek_repeat", .label = "peek", .expected = config.expected_peek_complexity },
+        .{ .operation = "remove_all", .label = "remove", .expected = config.expected_remove_complexity },
+    };
+
+    var name_buf: [256]u8 = undefined;
+    const name = std.fmt.bufPrint(&name_buf, "{s} (complexity fit)", .{config.name}) catch config.name;
+    var result = TestCaseResult.init(name, allocator);
+    errdefer result.deinit();
+    var mismatches = std.ArrayList(u8).init(allocator);
+    defer mismatches.deinit();
+
+    var fitted_any = false;
+    for (checks) |check| {
+        const samples = try complexity.collectSamples(allocator, measurements.items, check.operation);
+        defer allocator.free(samples);
+        const fit = complexity.bestFit(samples);
+        if (fit.complexity == .InsufficientData) {
+            try logging.log(.Debug, "  {s}: only {d} input sizes for {s}, not fitting a complexity\n", .{ config.name, samples.len, check.label });
+            continue;
+        }
+        fitted_any = true;
+        try logging.log(.Info, "  {s}: {s} fits {s} ({d:.3}ns * g(N), rms {d:.1}%, confidence {d:.2})\n", .{
+            config.name, check.label, @tagName(fit.complexity), fit.coefficient, fit.rms * 100, fit.confidence,
+        });
+
+        if (!complexity.isCandidate(check.expected) or check.expected == fit.complexity) continue;
+        if (fit.confidence < config.complexity_min_confidence) {
+            try logging.log(.Warning, "  {s}: {s} expected {s}, best fit {s} is too uncertain to fail on\n", .{
+                config.name, check.label, @tagName(check.expected), @tagName(fit.complexity),
+            });
+            continue;
+        }
+        if (mismatches.items.len > 0) try mismatches.appendSlice("; ");
+        try mismatches.writer().print("{s}: expected {s}, fitted {s} (confidence {d:.2})", .{
+            check.label, @tagName(check.expected), @tagName(fit.complexity), fit.confidence,
+        });
+    }
+
+    if (!fitted_any) {
+        result.deinit();
+        return null;
+    }
+    if (mismatches.items.len > 0) {
+        result.recordFailure("Measured complexity disagrees with the expected complexity", mismatches.items, null, null);
+    }
+    return result;
+}
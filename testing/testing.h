@@ -15,7 +15,8 @@ enum testingResultCode_e {
   ADT_RESULT_ERROR_EMPTY = -2,
   ADT_RESULT_ERROR_ALLOC = -3,
   ADT_RESULT_ERROR_INVALID_HANDLE = -5,
-  ADT_RESULT_ERROR_OTHER = -4
+  ADT_RESULT_ERROR_OTHER = -4,
+  ADT_RESULT_ERROR_FULL = -6
 };
 
 typedef enum testingResultCode_e testingResultCode;
@@ -65,6 +66,103 @@ void notify_compare_lte(void);
  * (>=). */
 void notify_compare_gte(void);
 
+/*--- TrackedItem statistics ---*/
+struct TrackedItemStats_s {
+  unsigned long long default_constructs;
+  unsigned long long value_constructs;
+  unsigned long long destructs;
+  unsigned long long copy_constructs;
+  unsigned long long copy_assigns;
+  unsigned long long move_constructs;
+  unsigned long long move_assigns;
+  unsigned long long compare_eq;
+  unsigned long long compare_lt;
+  unsigned long long compare_gt;
+  unsigned long long compare_neq;
+  unsigned long long compare_lte;
+  unsigned long long compare_gte;
+};
+typedef struct TrackedItemStats_s TrackedItemStats;
+/** @brief Returns the TrackedItem operation counts collected so far, summed
+ * over every thread. Exact once the counting threads are quiescent. */
+TrackedItemStats tracked_item_stats(void);
+/** @brief Resets every TrackedItem operation count to zero. Call it while no
+ * other thread is using TrackedItems. */
+void reset_tracked_item_stats(void);
+/** @brief Adds a thread's counter block to the totals. The owning thread
+ * increments it with relaxed atomics, Zig reads it the same way. */
+void register_tracked_item_counters(TrackedItemStats *counters);
+/** @brief Folds a thread's counts into the totals and forgets the block. */
+void unregister_tracked_item_counters(TrackedItemStats *counters);
+
+/*--- Hardware performance counters ---*/
+/* Counts of one region of the calling thread, user space only. An event the
+ * CPU or kernel could not count is -1. */
+struct PerfCounts_s {
+  long long cycles;
+  long long instructions;
+  long long l1d_read_misses;
+  long long llc_read_misses;
+  long long branch_misses;
+  long long dtlb_read_misses;
+};
+typedef struct PerfCounts_s PerfCounts;
+typedef struct PerfCounterGroup_s PerfCounterGroup;
+/** @brief Opens a perf_event_open counter group for the calling thread.
+ * Returns NULL when no hardware counter is available (VMs, containers,
+ * perf_event_paranoid); the other functions accept NULL and do nothing. */
+PerfCounterGroup *perf_counters_open(void);
+/** @brief Resets and starts every counter of the group. */
+void perf_counters_start(PerfCounterGroup *group);
+/** @brief Stops the group and returns the counts since the last start. */
+PerfCounts perf_counters_stop(PerfCounterGroup *group);
+/** @brief Closes the group and frees it. */
+void perf_counters_close(PerfCounterGroup *group);
+
+/*--- Heap accounting ---*/
+/* Calls to the global operator new/delete of a binary built with
+ * TESTING_TRACK_HEAP, since it started. */
+struct HeapStats_s {
+  unsigned long long allocations;
+  unsigned long long frees;
+  unsigned long long bytes_allocated;
+  unsigned long long bytes_freed;
+  unsigned long long live_bytes;
+  /* Highest live_bytes seen; Zig lowers it to live_bytes at the start of
+   * each measured phase. */
+  unsigned long long peak_live_bytes;
+};
+typedef struct HeapStats_s HeapStats;
+/** @brief Hands Zig the counter block the replaced operator new/delete
+ * update with relaxed atomics. Called once, before main. */
+void register_heap_counters(HeapStats *counters);
+
+/*--- Input distributions ---*/
+/* Must match TestInputType in input_generators.zig. */
+enum InputDistribution_e {
+  InputSorted = 0,
+  InputReversed,
+  InputRandomUnique,
+  InputFewUnique,
+  InputNearlySorted,
+  InputEmpty,
+  InputOrganPipe,
+  InputSawtooth,
+  InputZipf,
+  InputAllEqual,
+  InputSortedPrefix,
+  InputSortedSuffix,
+  InputDistributionCount
+};
+typedef enum InputDistribution_e InputDistribution;
+/** @brief Writes size values of the harness input generator for
+ * distribution, seeded with seed, to values_out. Returns how many were
+ * written (none for InputEmpty) or a negative testingResultCode. */
+int generate_input_values(InputDistribution distribution, int size,
+                          unsigned long long seed, int *values_out);
+/** @brief The generator's name for distribution, e.g. "Zipf". */
+const char *input_distribution_name(InputDistribution distribution);
+
 /*--- Testing Options ---*/
 enum Verbosity_e {
   Error = 0,
@@ -78,18 +176,23 @@ enum InsertionOrder_e {
   Unknown = 0,
   FirstInFirstOut = -1,
   FirstInLastOut = -2,
+  SortedValue = -3,
+  Undefined = -4,
 };
 
 typedef enum InsertionOrder_e InsertionOrder;
 typedef struct adtOperations_s adtOperations;
+/* Must match Complexity in adt_options.zig. */
 enum Complexity_e {
   None = 0,
   O1 = -1,
-  ON = -2,
-  ONLogN = -3,
-  ON2 = -4,
-  Undetermined = -5,
-  InsufficientData = -6
+  OLogN = -2,
+  ON = -3,
+  ONLogN = -4,
+  ON2 = -5,
+  Undetermined = -6,
+  InsufficientData = -7,
+  NotApplicable = -8
 };
 typedef enum Complexity_e Complexity;
 struct adtSimpleTestingOptions_s {
@@ -99,10 +202,28 @@ struct adtSimpleTestingOptions_s {
   bool sorted_output;
   int *input_sizes;
   int input_sizes_size;
-  bool estimate_complexity;
-  Complexity expected_insert_complexity;
+  bool estimate_complexity; /* fit each operation over all input_sizes */
+  Complexity expected_insert_complexity; /* None skips the check */
   Complexity expected_peek_complexity;
   Complexity expected_remove_complexity;
+  int num_iterations;            /* runs of every test case */
+  int max_operations_for_timing; /* operations per timed benchmark region */
+  bool perf_counters; /* hardware counters per timed phase, if available */
+  /* Worker threads for test cases. 1, the default, runs them in order on
+   * the calling thread; 0 is one per CPU. Timing-sensitive cases always run
+   * alone. */
+  int test_threads;
+  unsigned long long seed; /* master PRNG seed, 0 picks one from the clock */
+  /* Statistical benchmark, run after the tests when enabled. Latencies are
+   * reported per operation as min/median/p99 over sub-batches of 64
+   * operations from all repetitions. */
+  bool benchmark;
+  int benchmark_warmup_iterations;
+  int benchmark_repetitions;
+  bool benchmark_all_inputs;       /* every distribution, not only random */
+  int benchmark_pin_cpu;           /* -1 leaves the CPU affinity alone */
+  const char *benchmark_csv_path;  /* NULL to skip, appended to */
+  const char *benchmark_json_path; /* NULL to skip, JSON Lines */
 };
 typedef struct adtSimpleTestingOptions_s adtSimpleTestingOptions;
 adtSimpleTestingOptions default_adtSimpleTestingOptions(const char *name);
@@ -111,6 +232,14 @@ typedef void *ADTHandle;
 
 /*--- Testing simple ADT Operations ---*/
 
+/* Node allocations an ADT has requested, and how many of them reached the
+ * global heap. */
+struct AllocatorStats_s {
+  unsigned long long allocations;
+  unsigned long long heap_allocations;
+};
+typedef struct AllocatorStats_s AllocatorStats;
+
 struct adtOperations_s {
   testingResultCode (*insert)(ADTHandle handle, CTrackedItem value);
   testingResultCode (*remove)(ADTHandle handle, TrackedItemHandle *value_out);
@@ -118,11 +247,47 @@ struct adtOperations_s {
   testingResultCode (*create)(
       ADTHandle *handle_out); // allways nullptr otherwise unsafe
   testingResultCode (*destroy)(ADTHandle handle);
+  /* Optional, may be NULL. Cumulative allocator counters of the ADT. */
+  testingResultCode (*allocator_stats)(ADTHandle handle,
+                                       AllocatorStats *stats_out);
+  /* Optional, may be NULL. Insert items[0..n) / remove n items into out[0..n)
+   * in one call, with no allocation by the harness. On failure the code is
+   * that of the failing element and *done_out (if not NULL) counts the
+   * elements handled before it. */
+  testingResultCode (*insert_batch)(ADTHandle handle, const CTrackedItem *items,
+                                    size_t n, size_t *done_out);
+  testingResultCode (*remove_batch)(ADTHandle handle, CTrackedItem *out,
+                                    size_t n, size_t *done_out);
+};
+
+/*--- Testing concurrent ADT Operations ---*/
+struct adtConcurrentTestingOptions_s {
+  char *name;
+  /* Each entry runs one case with that many producers and as many
+   * consumers. A single-producer/single-consumer ADT should only list 1. */
+  int *thread_counts;
+  int thread_counts_size;
+  int items_per_producer;
+  /* FirstInFirstOut (the default) checks per-producer FIFO order.
+   * SortedValue treats the ADT as a priority queue: each case fills it from
+   * that many threads, drains it from as many, and reports throughput and
+   * rank error, i.e. how many smaller items were still queued on average
+   * when each item came out. */
+  InsertionOrder order;
 };
+typedef struct adtConcurrentTestingOptions_s adtConcurrentTestingOptions;
+adtConcurrentTestingOptions
+default_adtConcurrentTestingOptions(const char *name);
 
 /*--- Testing functions that exist ---*/
 int test_test(adtOperations *);
 int test_adt(adtOperations *, adtSimpleTestingOptions *);
+/** @brief Stress tests an ADT from several threads at once. Every operation
+ * may run concurrently with any other, and insert may fail with
+ * ADT_RESULT_ERROR_FULL. Checks that items from each producer are removed in
+ * FIFO order, or for SortedValue that every item comes out exactly once, and
+ * reports throughput per thread count. */
+int test_adt_concurrent(adtOperations *, adtConcurrentTestingOptions *);
 
 #ifdef __cplusplus
 }
@@ -134,7 +299,249 @@ int test_adt(adtOperations *, adtSimpleTestingOptions *);
 #ifndef TESTING_HPP
 #define TESTING_HPP
 
+#include <atomic>
 #include <ostream>
+#include <stdexcept>
+
+/*--- TrackedItem instrumentation ---*/
+/* Chosen per translation unit before including this header:
+ *   OFF          TrackedItem counts nothing and costs nothing.
+ *   THREAD_LOCAL each thread bumps its own counter block inline, and
+ *                tracked_item_stats() sums the blocks. The default.
+ *   FULL         every event calls the out-of-line notify_* function. */
+#define TRACKED_ITEM_INSTRUMENTATION_OFF 0
+#define TRACKED_ITEM_INSTRUMENTATION_THREAD_LOCAL 1
+#define TRACKED_ITEM_INSTRUMENTATION_FULL 2
+#ifndef TRACKED_ITEM_INSTRUMENTATION
+#define TRACKED_ITEM_INSTRUMENTATION TRACKED_ITEM_INSTRUMENTATION_THREAD_LOCAL
+#endif
+
+#if TRACKED_ITEM_INSTRUMENTATION == TRACKED_ITEM_INSTRUMENTATION_THREAD_LOCAL
+namespace tracked_item_detail {
+struct ThreadCounters {
+  TrackedItemStats stats;
+  bool registered;
+  // Set once the block was unregistered at thread exit.
+  bool exited;
+};
+// Constant-initialized, so reaching it is a plain TLS access with no
+// initialization guard.
+inline constinit thread_local ThreadCounters threadCounters{};
+
+struct ThreadCountersOwner {
+  ~ThreadCountersOwner() {
+    unregister_tracked_item_counters(&threadCounters.stats);
+    threadCounters.registered = false;
+    threadCounters.exited = true;
+  }
+};
+
+inline void RegisterThread() {
+  // Constructed on the first call per thread; unregisters at thread exit.
+  thread_local ThreadCountersOwner owner;
+  (void)owner;
+  register_tracked_item_counters(&threadCounters.stats);
+  threadCounters.registered = true;
+}
+
+// Only the owning thread writes its block, so a relaxed load and store is
+// exact and needs no locked instruction. Readers on other threads see a
+// consistent value instead of a data race. Returns false for counts made
+// after the block was unregistered at thread exit (e.g. by later
+// thread_local destructors); its storage is about to go away, so the caller
+// counts those through the shared notify_* path instead.
+inline bool Increment(unsigned long long TrackedItemStats::*field) {
+  if (!threadCounters.registered) [[unlikely]] {
+    if (threadCounters.exited) {
+      return false;
+    }
+    RegisterThread();
+  }
+  std::atomic_ref<unsigned long long> counter(threadCounters.stats.*field);
+  counter.store(counter.load(std::memory_order_relaxed) + 1,
+                std::memory_order_relaxed);
+  return true;
+}
+} // namespace tracked_item_detail
+#define TRACKED_ITEM_COUNT(FIELD, NOTIFY_CALL)                                 \
+  (tracked_item_detail::Increment(&TrackedItemStats::FIELD) ? (void)0          \
+                                                            : NOTIFY_CALL)
+#elif TRACKED_ITEM_INSTRUMENTATION == TRACKED_ITEM_INSTRUMENTATION_FULL
+#define TRACKED_ITEM_COUNT(FIELD, NOTIFY_CALL) NOTIFY_CALL
+#else
+#define TRACKED_ITEM_COUNT(FIELD, NOTIFY_CALL) ((void)0)
+#endif
+
+/*--- Heap accounting ---*/
+/* Off by default. Define TESTING_TRACK_HEAP (zig build -Dtrack-heap) to
+ * replace the global operator new/delete of the binary with ones that count
+ * calls and bytes, so test_adt reports the heap traffic of every timed phase.
+ * Each block carries its size in a header in front of it, which lets unsized
+ * delete count the bytes freed. The counters are shared atomics, so this
+ * slows down allocation-heavy ADTs and their timings, concurrent ones most. */
+#ifdef TESTING_TRACK_HEAP
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+namespace heap_tracking_detail {
+inline constinit HeapStats heapStats{};
+// Internal linkage, so the registration runs even though nothing reads it.
+[[maybe_unused]] static const bool heapStatsRegistered =
+    (register_heap_counters(&heapStats), true);
+
+inline std::atomic_ref<unsigned long long> Counter(unsigned long long &field) {
+  return std::atomic_ref<unsigned long long>(field);
+}
+
+inline void CountAllocation(std::size_t size) {
+  Counter(heapStats.allocations).fetch_add(1, std::memory_order_relaxed);
+  Counter(heapStats.bytes_allocated)
+      .fetch_add(size, std::memory_order_relaxed);
+  unsigned long long live =
+      Counter(heapStats.live_bytes).fetch_add(size, std::memory_order_relaxed);
+  live += size;
+  auto peak = Counter(heapStats.peak_live_bytes);
+  unsigned long long seen = peak.load(std::memory_order_relaxed);
+  while (live > seen &&
+         !peak.compare_exchange_weak(seen, live, std::memory_order_relaxed)) {
+  }
+}
+
+inline void CountFree(std::size_t size) {
+  Counter(heapStats.frees).fetch_add(1, std::memory_order_relaxed);
+  Counter(heapStats.bytes_freed).fetch_add(size, std::memory_order_relaxed);
+  Counter(heapStats.live_bytes).fetch_sub(size, std::memory_order_relaxed);
+}
+
+// The header keeps the block aligned, and its last bytes hold the size.
+inline std::size_t HeaderSize(std::size_t alignment) {
+  return alignment > alignof(std::max_align_t) ? alignment
+                                               : alignof(std::max_align_t);
+}
+
+inline void *Allocate(std::size_t size, std::size_t alignment) noexcept {
+  std::size_t header = HeaderSize(alignment);
+  if (size > static_cast<std::size_t>(-1) - 2 * header) {
+    return nullptr;
+  }
+  void *block;
+  if (alignment > alignof(std::max_align_t)) {
+    // aligned_alloc wants a multiple of the alignment.
+    std::size_t rounded = (header + size + alignment - 1) & ~(alignment - 1);
+    block = std::aligned_alloc(alignment, rounded);
+  } else {
+    block = std::malloc(header + size);
+  }
+  if (!block) {
+    return nullptr;
+  }
+  unsigned char *user = static_cast<unsigned char *>(block) + header;
+  std::memcpy(user - sizeof(std::size_t), &size, sizeof(std::size_t));
+  CountAllocation(size);
+  return user;
+}
+
+inline void *AllocateOrThrow(std::size_t size, std::size_t alignment) {
+  for (;;) {
+    if (void *user = Allocate(size, alignment)) {
+      return user;
+    }
+    std::new_handler handler = std::get_new_handler();
+    if (!handler) {
+      throw std::bad_alloc();
+    }
+    handler();
+  }
+}
+
+inline void Deallocate(void *ptr, std::size_t alignment) noexcept {
+  if (!ptr) {
+    return;
+  }
+  unsigned char *user = static_cast<unsigned char *>(ptr);
+  std::size_t size;
+  std::memcpy(&size, user - sizeof(std::size_t), sizeof(std::size_t));
+  CountFree(size);
+  std::free(user - HeaderSize(alignment));
+}
+} // namespace heap_tracking_detail
+
+// Replacement functions may not be inline, so like the rest of this header
+// they are defined in the one translation unit that includes it.
+void *operator new(std::size_t size) {
+  return heap_tracking_detail::AllocateOrThrow(size, 0);
+}
+void *operator new[](std::size_t size) {
+  return heap_tracking_detail::AllocateOrThrow(size, 0);
+}
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept {
+  return heap_tracking_detail::Allocate(size, 0);
+}
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept {
+  return heap_tracking_detail::Allocate(size, 0);
+}
+void *operator new(std::size_t size, std::align_val_t alignment) {
+  return heap_tracking_detail::AllocateOrThrow(
+      size, static_cast<std::size_t>(alignment));
+}
+void *operator new[](std::size_t size, std::align_val_t alignment) {
+  return heap_tracking_detail::AllocateOrThrow(
+      size, static_cast<std::size_t>(alignment));
+}
+void *operator new(std::size_t size, std::align_val_t alignment,
+                   const std::nothrow_t &) noexcept {
+  return heap_tracking_detail::Allocate(size,
+                                        static_cast<std::size_t>(alignment));
+}
+void *operator new[](std::size_t size, std::align_val_t alignment,
+                     const std::nothrow_t &) noexcept {
+  return heap_tracking_detail::Allocate(size,
+                                        static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void *ptr) noexcept {
+  heap_tracking_detail::Deallocate(ptr, 0);
+}
+void operator delete[](void *ptr) noexcept {
+  heap_tracking_detail::Deallocate(ptr, 0);
+}
+void operator delete(void *ptr, std::size_t) noexcept {
+  heap_tracking_detail::Deallocate(ptr, 0);
+}
+void operator delete[](void *ptr, std::size_t) noexcept {
+  heap_tracking_detail::Deallocate(ptr, 0);
+}
+void operator delete(void *ptr, const std::nothrow_t &) noexcept {
+  heap_tracking_detail::Deallocate(ptr, 0);
+}
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept {
+  heap_tracking_detail::Deallocate(ptr, 0);
+}
+void operator delete(void *ptr, std::align_val_t alignment) noexcept {
+  heap_tracking_detail::Deallocate(ptr, static_cast<std::size_t>(alignment));
+}
+void operator delete[](void *ptr, std::align_val_t alignment) noexcept {
+  heap_tracking_detail::Deallocate(ptr, static_cast<std::size_t>(alignment));
+}
+void operator delete(void *ptr, std::size_t,
+                     std::align_val_t alignment) noexcept {
+  heap_tracking_detail::Deallocate(ptr, static_cast<std::size_t>(alignment));
+}
+void operator delete[](void *ptr, std::size_t,
+                       std::align_val_t alignment) noexcept {
+  heap_tracking_detail::Deallocate(ptr, static_cast<std::size_t>(alignment));
+}
+void operator delete(void *ptr, std::align_val_t alignment,
+                     const std::nothrow_t &) noexcept {
+  heap_tracking_detail::Deallocate(ptr, static_cast<std::size_t>(alignment));
+}
+void operator delete[](void *ptr, std::align_val_t alignment,
+                       const std::nothrow_t &) noexcept {
+  heap_tracking_detail::Deallocate(ptr, static_cast<std::size_t>(alignment));
+}
+#endif
 
 /*--- Cpp Struct Info ---*/
 struct TrackedItem {
@@ -151,60 +558,62 @@ public:
     this->order = tr.order;
     this->value = tr.value;
   }
-  TrackedItem() : value(0), order(0) { notify_default_construct(); }
+  TrackedItem() : value(0), order(0) {
+    TRACKED_ITEM_COUNT(default_constructs, notify_default_construct());
+  }
   TrackedItem(int v, int o) : value(v), order(o) {
-    notify_value_construct(v, o);
+    TRACKED_ITEM_COUNT(value_constructs, notify_value_construct(v, o));
   }
-  ~TrackedItem() { notify_destruct(); }
+  ~TrackedItem() { TRACKED_ITEM_COUNT(destructs, notify_destruct()); }
   TrackedItem(const TrackedItem &other)
       : value(other.value), order(other.order) {
-    notify_copy_construct();
+    TRACKED_ITEM_COUNT(copy_constructs, notify_copy_construct());
   }
   TrackedItem &operator=(const TrackedItem &other) {
     if (this != &other) {
       value = other.value;
       order = other.order;
-      notify_copy_assign();
+      TRACKED_ITEM_COUNT(copy_assigns, notify_copy_assign());
     }
     return *this;
   }
   TrackedItem(TrackedItem &&other) noexcept
       : value(other.value), order(other.order) {
-    notify_move_construct();
+    TRACKED_ITEM_COUNT(move_constructs, notify_move_construct());
   }
   TrackedItem &operator=(TrackedItem &&other) noexcept {
     if (this != &other) {
       value = other.value;
       order = other.order;
-      notify_move_assign();
+      TRACKED_ITEM_COUNT(move_assigns, notify_move_assign());
     }
     return *this;
   }
 
   bool operator==(const TrackedItem &rhs) const {
-    notify_compare_eq();
+    TRACKED_ITEM_COUNT(compare_eq, notify_compare_eq());
     return this->value == rhs.value;
   }
 
   bool operator<(const TrackedItem &rhs) const {
-    notify_compare_lt();
+    TRACKED_ITEM_COUNT(compare_lt, notify_compare_lt());
     return this->value < rhs.value;
   }
 
   bool operator!=(const TrackedItem &rhs) const {
-    notify_compare_neq();
+    TRACKED_ITEM_COUNT(compare_neq, notify_compare_neq());
     return this->value != rhs.value;
   }
   bool operator>(const TrackedItem &rhs) const {
-    notify_compare_gt();
+    TRACKED_ITEM_COUNT(compare_gt, notify_compare_gt());
     return this->value != rhs.value;
   }
   bool operator<=(const TrackedItem &rhs) const {
-    notify_compare_lte();
+    TRACKED_ITEM_COUNT(compare_lte, notify_compare_lte());
     return this->value <= rhs.value;
   }
   bool operator>=(const TrackedItem &rhs) const {
-    notify_compare_gte();
+    TRACKED_ITEM_COUNT(compare_gte, notify_compare_gte());
     return this->value >= rhs.value;
   }
 
@@ -328,7 +737,8 @@ inline std::ostream &operator<<(std::ostream &os, const TrackedItem &obj) {
  * @param CPP_METHOD_NAME The name of the member function for insert (e.g.,
  * push). This function must exist on CPP_TYPE and accept a TrackedItem argument
  * (usually by value or const ref).
- * @warning Assumes the method may throw std::bad_alloc on allocation failure.
+ * @warning Assumes the method may throw std::bad_alloc on allocation failure,
+ * and std::overflow_error if a bounded container is full.
  */
 #define CREATE_INSERT_FN_PTR(CPP_TYPE, CPP_METHOD_NAME)                        \
   ([](ADTHandle handle, CTrackedItem value) -> testingResultCode {             \
@@ -345,6 +755,8 @@ inline std::ostream &operator<<(std::ostream &os, const TrackedItem &obj) {
       return ADT_RESULT_SUCCESS;                                               \
     } catch (const std::bad_alloc &) {                                         \
       return ADT_RESULT_ERROR_ALLOC;                                           \
+    } catch (const std::overflow_error &) {                                    \
+      return ADT_RESULT_ERROR_FULL;                                            \
     } catch (const std::exception &) {                                         \
       return ADT_RESULT_ERROR_OTHER;                                           \
     } catch (...) {                                                            \
@@ -401,6 +813,110 @@ inline std::ostream &operator<<(std::ostream &os, const TrackedItem &obj) {
       return ADT_RESULT_ERROR_OTHER;                                           \
     }                                                                          \
   }) // End of lambda
+/**
+ * @brief Generates a C function pointer for an 'insert_batch' operation that
+ * calls CPP_METHOD_NAME once per element of the caller's array.
+ * @param CPP_TYPE The C++ class type (e.g., StackLinkedList<TrackedItem>).
+ * @param CPP_METHOD_NAME The insert method, as for CREATE_INSERT_FN_PTR.
+ */
+#define CREATE_INSERT_BATCH_FN_PTR(CPP_TYPE, CPP_METHOD_NAME)                  \
+  ([](ADTHandle handle, const CTrackedItem *items, size_t n,                   \
+      size_t *done_out) -> testingResultCode {                                 \
+    /* Static lambda - NO CAPTURE */                                           \
+    size_t done = 0;                                                           \
+    testingResultCode result = ADT_RESULT_SUCCESS;                             \
+    if (!handle) {                                                             \
+      result = ADT_RESULT_ERROR_INVALID_HANDLE;                                \
+    } else if (!items && n > 0) {                                              \
+      result = ADT_RESULT_ERROR_NULL_PTR;                                      \
+    } else {                                                                   \
+      CPP_TYPE *sl = static_cast<CPP_TYPE *>(handle);                          \
+      try {                                                                    \
+        for (; done < n; done++) {                                             \
+          sl->CPP_METHOD_NAME(TrackedItem(items[done]));                       \
+        }                                                                      \
+      } catch (const std::bad_alloc &) {                                       \
+        result = ADT_RESULT_ERROR_ALLOC;                                       \
+      } catch (const std::overflow_error &) {                                  \
+        result = ADT_RESULT_ERROR_FULL;                                        \
+      } catch (...) {                                                          \
+        result = ADT_RESULT_ERROR_OTHER;                                       \
+      }                                                                        \
+    }                                                                          \
+    if (done_out) {                                                            \
+      *done_out = done;                                                        \
+    }                                                                          \
+    return result;                                                             \
+  }) // End of lambda
+
+/**
+ * @brief Generates a C function pointer for a 'remove_batch' operation that
+ * removes n elements into the caller's array, without allocating.
+ * @param CPP_TYPE The C++ class type (e.g., StackLinkedList<TrackedItem>).
+ * @param CPP_METHOD_NAME The remove method, as for CREATE_REMOVE_FN_PTR.
+ */
+#define CREATE_REMOVE_BATCH_FN_PTR(CPP_TYPE, CPP_METHOD_NAME)                  \
+  ([](ADTHandle handle, CTrackedItem *out, size_t n,                           \
+      size_t *done_out) -> testingResultCode {                                 \
+    /* Static lambda - NO CAPTURE */                                           \
+    size_t done = 0;                                                           \
+    testingResultCode result = ADT_RESULT_SUCCESS;                             \
+    if (!handle) {                                                             \
+      result = ADT_RESULT_ERROR_INVALID_HANDLE;                                \
+    } else if (!out && n > 0) {                                                \
+      result = ADT_RESULT_ERROR_NULL_PTR;                                      \
+    } else {                                                                   \
+      CPP_TYPE *sl = static_cast<CPP_TYPE *>(handle);                          \
+      try {                                                                    \
+        for (; done < n; done++) {                                             \
+          TrackedItem removed_item = sl->CPP_METHOD_NAME();                    \
+          out[done].value = removed_item.value;                                \
+          out[done].order = removed_item.order;                                \
+        }                                                                      \
+      } catch (const std::out_of_range &) {                                    \
+        result = ADT_RESULT_ERROR_EMPTY;                                       \
+      } catch (const std::bad_alloc &) {                                       \
+        result = ADT_RESULT_ERROR_ALLOC;                                       \
+      } catch (...) {                                                          \
+        result = ADT_RESULT_ERROR_OTHER;                                       \
+      }                                                                        \
+    }                                                                          \
+    if (done_out) {                                                            \
+      *done_out = done;                                                        \
+    }                                                                          \
+    return result;                                                             \
+  }) // End of lambda
+
+/**
+ * @brief Generates a C function pointer for the optional 'allocator_stats'
+ * operation, or nullptr if CPP_TYPE has no allocator_stats() method.
+ * @param CPP_TYPE The C++ class type. Its allocator_stats() must return an
+ * object with `allocations` and `heap_allocations` members (e.g.
+ * NodePoolStats).
+ */
+#define CREATE_ALLOCATOR_STATS_FN_PTR(CPP_TYPE)                                \
+  /* Templated so the branch not taken is discarded, not compiled */           \
+  ([]<class ADT>() -> testingResultCode (*)(ADTHandle, AllocatorStats *) {     \
+    if constexpr (requires(const ADT &adt) { adt.allocator_stats(); }) {       \
+      return [](ADTHandle handle,                                              \
+                AllocatorStats *stats_out) -> testingResultCode {              \
+        if (!stats_out) {                                                      \
+          return ADT_RESULT_ERROR_NULL_PTR;                                    \
+        }                                                                      \
+        if (!handle) {                                                         \
+          return ADT_RESULT_ERROR_INVALID_HANDLE;                              \
+        }                                                                      \
+        const auto &stats =                                                    \
+            static_cast<const ADT *>(handle)->allocator_stats();               \
+        stats_out->allocations = stats.allocations;                            \
+        stats_out->heap_allocations = stats.heap_allocations;                  \
+        return ADT_RESULT_SUCCESS;                                             \
+      };                                                                       \
+    } else {                                                                   \
+      return nullptr;                                                          \
+    }                                                                          \
+  }.template operator()<CPP_TYPE>())
+
 /**
  * @brief Creates and populates an adtOperations struct for a given C++ type and
  * its methods.
@@ -413,6 +929,10 @@ inline std::ostream &operator<<(std::ostream &os, const TrackedItem &obj) {
  * @param PEEK_METHOD_NAME The name of the *const* C++ method for peeking (e.g.,
  * peek). Must return a const TrackedItem&.
  *
+ * If CPP_TYPE has an allocator_stats() method, allocator_stats is filled in as
+ * well and the harness reports allocator calls per operation. insert_batch
+ * and remove_batch are always filled in from the insert and remove methods.
+ *
  * @return A pointer to a newly allocated adtOperations struct, or nullptr on
  * failure. The caller is responsible for deleting the returned struct when no
  * longer needed.
@@ -439,6 +959,11 @@ inline std::ostream &operator<<(std::ostream &os, const TrackedItem &obj) {
     ops->insert = CREATE_INSERT_FN_PTR(CPP_TYPE, INSERT_METHOD_NAME);          \
     ops->remove = CREATE_REMOVE_FN_PTR(CPP_TYPE, REMOVE_METHOD_NAME);          \
     ops->peek = CREATE_PEEK_FN_PTR(CPP_TYPE, PEEK_METHOD_NAME);                \
+    ops->allocator_stats = CREATE_ALLOCATOR_STATS_FN_PTR(CPP_TYPE);            \
+    ops->insert_batch =                                                        \
+        CREATE_INSERT_BATCH_FN_PTR(CPP_TYPE, INSERT_METHOD_NAME);              \
+    ops->remove_batch =                                                        \
+        CREATE_REMOVE_BATCH_FN_PTR(CPP_TYPE, REMOVE_METHOD_NAME);              \
     /* --- Sanity Check --- */                                                 \
     /* Verify that all function pointers were successfully assigned */         \
     /* (macros should always generate valid pointers if compilation succeeds)  \
@@ -38,15 +38,18 @@ pub const TrackingObject = struct {
     }
 };
 pub fn resetStats() TrackedItemStats {
-    const temp: TrackedItemStats = g_stats;
-    g_stats = TrackedItemStats{};
+    registry_mutex.lock();
+    defer registry_mutex.unlock();
+    const temp = collectLocked();
+    resetLocked();
     return temp;
 }
 const std = @import("std");
 
 // Define the struct to hold the counts for each C++ operation.
 // Using u64 for counters to avoid overflow for a long time.
-const TrackedItemStats = struct {
+// Laid out like the C TrackedItemStats in testing.h, which reads it.
+pub const TrackedItemStats = extern struct {
     default_constructs: u64 = 0,
     value_constructs: u64 = 0,
     destructs: u64 = 0,
@@ -62,14 +65,88 @@ const TrackedItemStats = struct {
     compare_gte: u64 = 0,
 };
 
-// Declare a static (file-level) instance of the stats struct.
-// It's implicitly static because it's declared with 'var' at the top level
-// and not marked 'pub'. It will be initialized with all fields set to 0
-// based on the struct definition defaults.
+// Counts come from two places, depending on TRACKED_ITEM_INSTRUMENTATION in
+// the C++ translation unit: the notify_* functions below bump g_stats
+// atomically (FULL), and each C++ thread registers its own block that only
+// it writes (THREAD_LOCAL). Blocks of exited threads are folded into
+// retired. Every block is read with atomic loads, so totals taken while
+// other threads run are race free, and exact once those threads are idle.
 var g_stats: TrackedItemStats = TrackedItemStats{};
+var registry_mutex: std.Thread.Mutex = .{};
+var registered: std.ArrayListUnmanaged(*TrackedItemStats) = .{};
+var retired: TrackedItemStats = TrackedItemStats{};
+
+const stat_fields = std.meta.fields(TrackedItemStats);
+
+fn load(stats: *const TrackedItemStats) TrackedItemStats {
+    var result = TrackedItemStats{};
+    inline for (stat_fields) |field| {
+        @field(result, field.name) = @atomicLoad(u64, &@field(stats.*, field.name), .monotonic);
+    }
+    return result;
+}
+
+fn addInto(total: *TrackedItemStats, stats: TrackedItemStats) void {
+    inline for (stat_fields) |field| {
+        @field(total.*, field.name) += @field(stats, field.name);
+    }
+}
+
+fn zero(stats: *TrackedItemStats) void {
+    inline for (stat_fields) |field| {
+        @atomicStore(u64, &@field(stats.*, field.name), 0, .monotonic);
+    }
+}
+
+fn collectLocked() TrackedItemStats {
+    var total = load(&g_stats);
+    addInto(&total, retired);
+    for (registered.items) |block| addInto(&total, load(block));
+    return total;
+}
+
+fn resetLocked() void {
+    zero(&g_stats);
+    retired = TrackedItemStats{};
+    for (registered.items) |block| zero(block);
+}
+
+fn bump(comptime field: []const u8) void {
+    _ = @atomicRmw(u64, &@field(g_stats, field), .Add, 1, .monotonic);
+}
+
+export fn tracked_item_stats() TrackedItemStats {
+    registry_mutex.lock();
+    defer registry_mutex.unlock();
+    return collectLocked();
+}
+
+export fn reset_tracked_item_stats() void {
+    registry_mutex.lock();
+    defer registry_mutex.unlock();
+    resetLocked();
+}
+
+export fn register_tracked_item_counters(counters: *TrackedItemStats) void {
+    registry_mutex.lock();
+    defer registry_mutex.unlock();
+    registered.append(std.heap.c_allocator, counters) catch @panic("failed to register TrackedItem counters");
+}
+
+export fn unregister_tracked_item_counters(counters: *TrackedItemStats) void {
+    registry_mutex.lock();
+    defer registry_mutex.unlock();
+    for (registered.items, 0..) |block, i| {
+        if (block == counters) {
+            addInto(&retired, load(block));
+            _ = registered.swapRemove(i);
+            return;
+        }
+    }
+}
 
 export fn notify_default_construct() void {
-    g_stats.default_constructs += 1;
+    bump("default_constructs");
 }
 
 export fn notify_value_construct(value: c_int, order: c_int) void {
@@ -77,66 +154,67 @@ export fn notify_value_construct(value: c_int, order: c_int) void {
     // Use `_ = var` to explicitly mark them as unused if needed by the linter/compiler.
     _ = value;
     _ = order;
-    g_stats.value_constructs += 1;
+    bump("value_constructs");
 }
 
 export fn notify_destruct() void {
-    g_stats.destructs += 1;
+    bump("destructs");
 }
 
 export fn notify_copy_construct() void {
-    g_stats.copy_constructs += 1;
+    bump("copy_constructs");
 }
 
 export fn notify_copy_assign() void {
-    g_stats.copy_assigns += 1;
+    bump("copy_assigns");
 }
 
 export fn notify_move_construct() void {
-    g_stats.move_constructs += 1;
+    bump("move_constructs");
 }
 
 export fn notify_move_assign() void {
-    g_stats.move_assigns += 1;
+    bump("move_assigns");
 }
 
 export fn notify_compare_eq() void {
-    g_stats.compare_eq += 1;
+    bump("compare_eq");
 }
 
 export fn notify_compare_lt() void {
-    g_stats.compare_lt += 1;
+    bump("compare_lt");
 }
 
 export fn notify_compare_gt() void {
-    g_stats.compare_gt += 1;
+    bump("compare_gt");
 }
 
 export fn notify_compare_neq() void {
-    g_stats.compare_neq += 1;
+    bump("compare_neq");
 }
 
 export fn notify_compare_lte() void {
-    g_stats.compare_lte += 1;
+    bump("compare_lte");
 }
 
 export fn notify_compare_gte() void {
-    g_stats.compare_gte += 1;
+    bump("compare_gte");
 }
 
 pub fn printStats() void {
+    const stats = tracked_item_stats();
     std.debug.print("TrackedItem Stats:\n", .{});
-    std.debug.print("  Default Constructs: {d}\n", .{g_stats.default_constructs});
-    std.debug.print("  Value Constructs:   {d}\n", .{g_stats.value_constructs});
-    std.debug.print("  Destructs:          {d}\n", .{g_stats.destructs});
-    std.debug.print("  Copy Constructs:    {d}\n", .{g_stats.copy_constructs});
-    std.debug.print("  Copy Assigns:       {d}\n", .{g_stats.copy_assigns});
-    std.debug.print("  Move Constructs:    {d}\n", .{g_stats.move_constructs});
-    std.debug.print("  Move Assigns:       {d}\n", .{g_stats.move_assigns});
-    std.debug.print("  Compare ==:         {d}\n", .{g_stats.compare_eq});
-    std.debug.print("  Compare !=:         {d}\n", .{g_stats.compare_neq});
-    std.debug.print("  Compare <:          {d}\n", .{g_stats.compare_lt});
-    std.debug.print("  Compare <=:         {d}\n", .{g_stats.compare_lte});
-    std.debug.print("  Compare >:          {d}\n", .{g_stats.compare_gt});
-    std.debug.print("  Compare >=:         {d}\n", .{g_stats.compare_gte});
+    std.debug.print("  Default Constructs: {d}\n", .{stats.default_constructs});
+    std.debug.print("  Value Constructs:   {d}\n", .{stats.value_constructs});
+    std.debug.print("  Destructs:          {d}\n", .{stats.destructs});
+    std.debug.print("  Copy Constructs:    {d}\n", .{stats.copy_constructs});
+    std.debug.print("  Copy Assigns:       {d}\n", .{stats.copy_assigns});
+    std.debug.print("  Move Constructs:    {d}\n", .{stats.move_constructs});
+    std.debug.print("  Move Assigns:       {d}\n", .{stats.move_assigns});
+    std.debug.print("  Compare ==:         {d}\n", .{stats.compare_eq});
+    std.debug.print("  Compare !=:         {d}\n", .{stats.compare_neq});
+    std.debug.print("  Compare <:          {d}\n", .{stats.compare_lt});
+    std.debug.print("  Compare <=:         {d}\n", .{stats.compare_lte});
+    std.debug.print("  Compare >:          {d}\n", .{stats.compare_gt});
+    std.debug.print("  Compare >=:         {d}\n", .{stats.compare_gte});
 }